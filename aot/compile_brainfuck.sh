@@ -0,0 +1,41 @@
+#!/bin/sh
+# Compiles a brainfuck source file ahead of time into an object file with a plain entry point (see aot/precompiled_program.cpp).
+# Usage: compile_brainfuck.sh <source.bf> <entry-point> <output.o> <cache-dir> <emit-assembly> <compiler-command...>
+#   entry-point: the name of the function, declare it with META_DECLARE_PRECOMPILED_BRAINFUCK(<entry-point>) where you use it
+#   emit-assembly: true or false, with true the generated assembly ends up next to the object (<output>.s)
+# The objects are cached by a hash of everything that goes into them: the brainfuck source, the entry point, the compiler command,
+# the compiler's --version output, meta_brainfuck_compiler.h and aot/precompiled_program.cpp. If nothing changed, the object is copied out of the cache instead of being compiled again.
+# NOTE: Doesn't care about timestamps at all, so a fresh checkout (CI) still hits the cache as long as the cache directory is kept around.
+
+set -e
+
+SOURCE="$1"
+ENTRY_POINT="$2"
+OUTPUT="$3"
+CACHE_DIR="$4"
+EMIT_ASSEMBLY="$5"
+shift 5
+
+# NOTE: The compiler command (with all its flags and defines) is part of the key, so a different -O or compiler is a different object.
+# The command alone doesn't say which version of the compiler it runs (c++ or clang++ can be upgraded under the same name), so its --version output is too.
+COMPILER_VERSION=$("$1" --version)
+KEY=$({ printf '%s\n' "$ENTRY_POINT" "$*" "$COMPILER_VERSION"; cat "$SOURCE" meta_brainfuck_compiler.h aot/precompiled_program.cpp; } | sha256sum | cut -d' ' -f1)
+CACHED="$CACHE_DIR/$KEY"
+
+mkdir -p "$CACHE_DIR" "$(dirname "$OUTPUT")"
+if [ ! -f "$CACHED.o" ] || { [ "$EMIT_ASSEMBLY" = true ] && [ ! -f "$CACHED.s" ]; }; then
+	# NOTE: Everything gets built in a directory of its own and only moved into the cache once it's done,
+	# so a failed or interrupted build (or two of them at once) never leaves a broken object in there.
+	BUILD_DIR=$(mktemp -d "$CACHE_DIR/build.XXXXXX")
+	trap 'rm -rf "$BUILD_DIR"' EXIT
+	{ printf 'R"BF('; cat "$SOURCE"; printf ')BF"\n'; } > "$BUILD_DIR/program.inc"
+	"$@" -c -I. -I"$BUILD_DIR" -DMETA_AOT_ENTRY_POINT="$ENTRY_POINT" -o "$BUILD_DIR/program.o" aot/precompiled_program.cpp
+	if [ "$EMIT_ASSEMBLY" = true ]; then
+		"$@" -S -I. -I"$BUILD_DIR" -DMETA_AOT_ENTRY_POINT="$ENTRY_POINT" -o "$BUILD_DIR/program.s" aot/precompiled_program.cpp
+		mv "$BUILD_DIR/program.s" "$CACHED.s"
+	fi
+	mv "$BUILD_DIR/program.o" "$CACHED.o"
+fi
+
+cp "$CACHED.o" "$OUTPUT"
+if [ "$EMIT_ASSEMBLY" = true ]; then cp "$CACHED.s" "${OUTPUT%.o}.s"; fi
@@ -0,0 +1,18 @@
+// Runs a brainfuck program that was compiled ahead of time (aot/example/hello.bf, see the aot-example make target).
+// This translation unit doesn't compile the program itself, it only links against the object that aot/compile_brainfuck.sh made.
+
+#include <cstdio>
+
+#include "meta_brainfuck_compiler.h"
+
+META_DECLARE_PRECOMPILED_BRAINFUCK(run_hello);
+
+int main() {
+	auto read_input_byte = []() -> uint16_t {
+		int character = getchar();
+		return character == EOF ? (uint16_t)-1 : (uint16_t)character;
+	};
+	auto write_output_bytes = [](const uint8_t* data, size_t length) -> bool { return fwrite(data, 1, length, stdout) == length; };
+
+	return meta::run_precompiled_brainfuck(run_hello, read_input_byte, write_output_bytes) == meta::brainfuck_run_return_t::SUCCESS ? 0 : 1;
+}
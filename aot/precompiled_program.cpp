@@ -0,0 +1,23 @@
+// Compiles one brainfuck program (program.inc, a raw string literal made from the .bf file) into an object file with a plain entry point.
+// The entry point is called META_AOT_ENTRY_POINT and is declared with META_DECLARE_PRECOMPILED_BRAINFUCK. See aot/compile_brainfuck.sh.
+// NOTE: Everything that changes the generated code (tape backend, bucket size, etc.) can be set with the META_AOT_TEMPLATE_ARGS define,
+// those are the template arguments of compiled_brainfuck_t that come after the functor types.
+
+#include "meta_brainfuck_compiler.h"
+
+#ifndef META_AOT_ENTRY_POINT
+#error "aot/precompiled_program.cpp: define META_AOT_ENTRY_POINT to the name of the entry point"
+#endif
+
+#ifndef META_AOT_TEMPLATE_ARGS
+#define META_AOT_TEMPLATE_ARGS META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT
+#endif
+
+static constexpr const char* source_code =
+#include "program.inc"
+;
+
+META_DECLARE_PRECOMPILED_BRAINFUCK(META_AOT_ENTRY_POINT) {
+	meta::compiled_brainfuck_t<source_code, meta::precompiled_input_t, meta::precompiled_output_t, META_AOT_TEMPLATE_ARGS> program(read_input_byte, write_output_byte);
+	return program.run();
+}
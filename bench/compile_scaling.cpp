@@ -0,0 +1,21 @@
+// Compile-time benchmark: compiles one generated brainfuck program (program.inc, which is a raw string literal).
+// The makefile generates the program in different sizes and measures how the compiler copes, see bench/compile_scaling.sh.
+
+#include <cstdio>
+
+#include "meta_brainfuck_compiler.h"
+
+static constexpr const char* source_code =
+#include "program.inc"
+;
+
+auto compiled_brainfuck_program = META_COMPILE_BRAINFUCK(source_code,
+		[]() -> uint16_t {
+			int character = getchar();
+			return character == EOF ? (uint16_t)-1 : (uint16_t)character;
+		},
+		[](uint8_t character) -> bool {
+			return putchar(character) != EOF;
+		});
+
+int main() { return compiled_brainfuck_program.run() == meta::brainfuck_run_return_t::SUCCESS ? 0 : 1; }
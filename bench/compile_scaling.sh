@@ -0,0 +1,26 @@
+#!/bin/sh
+# Generates brainfuck programs of growing length and reports compile time and peak compiler RSS for each of them.
+# Usage: compile_scaling.sh <measure-binary> <work-dir> <source-lengths> <compiler-command...>
+# Output: CSV with the header source_length,compile_seconds,peak_rss_kib,exit_status,instructions (instructions of the compiler, empty without perf events)
+
+set -e
+
+MEASURE="$1"
+WORK_DIR="$2"
+SOURCE_LENGTHS="$3"
+shift 3
+
+# NOTE: The chunk contains a bit of everything: folded runs, a multiply loop, a generic loop and comments.
+CHUNK='++++[>++++<-]>[<+>-]< +[>+[>++<-]<-]> this is a comment <'
+
+echo "source_length,compile_seconds,peak_rss_kib,exit_status,instructions"
+for SOURCE_LENGTH in $SOURCE_LENGTHS; do
+	PROGRAM_DIR="$WORK_DIR/compile_scaling_$SOURCE_LENGTH"
+	mkdir -p "$PROGRAM_DIR"
+	awk -v length_target="$SOURCE_LENGTH" -v chunk="$CHUNK" 'BEGIN {
+		printf "R\"BF("
+		for (written = 0; written + length(chunk) <= length_target; written += length(chunk)) { printf "%s", chunk }
+		printf ")BF\"\n"
+	}' > "$PROGRAM_DIR/program.inc"
+	"$MEASURE" "$SOURCE_LENGTH" "$@" -I"$PROGRAM_DIR" -o "$PROGRAM_DIR/program" bench/compile_scaling.cpp || true
+done
@@ -0,0 +1,111 @@
+// Runs a command and reports how long it took, how much memory it needed at its peak and how many instructions it retired.
+// Usage: measure [--stdin <file>] [--stdout <file>] <label> <command> [args...]
+// Output (one line, comma separated): label,wall_seconds,peak_rss_kib,exit_status,instructions
+// NOTE: instructions is empty if perf_event_open isn't available (not Linux, no permission, no PMU in the VM, etc.).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#if __has_include(<linux/perf_event.h>) && __has_include(<sys/syscall.h>)
+#define MEASURE_HAS_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+// NOTE: Opens an instruction counter for the child, which only starts counting once the child calls exec.
+// That way, the fork and the redirections in between don't show up in the count. Returns -1 if it doesn't work.
+static int open_instruction_counter(pid_t child) {
+#ifdef MEASURE_HAS_PERF_EVENTS
+	struct perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = PERF_TYPE_HARDWARE;
+	attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+	attributes.disabled = 1;
+	attributes.enable_on_exec = 1;
+	attributes.inherit = 1;
+	// NOTE: Kernel instructions aren't interesting here, and excluding them lets this work with perf_event_paranoid=2.
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	return (int)syscall(SYS_perf_event_open, &attributes, child, -1, -1, 0);
+#else
+	(void)child;
+	return -1;
+#endif
+}
+
+static bool redirect(const char* path, int target_fd, int flags) {
+	int fd = open(path, flags, 0644);
+	if (fd == -1) { perror(path); return false; }
+	if (dup2(fd, target_fd) == -1) { perror("dup2"); return false; }
+	close(fd);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	const char* stdin_path = nullptr;
+	const char* stdout_path = nullptr;
+	int argument_index = 1;
+	for (; argument_index + 1 < argc; argument_index += 2) {
+		if (strcmp(argv[argument_index], "--stdin") == 0) { stdin_path = argv[argument_index + 1]; }
+		else if (strcmp(argv[argument_index], "--stdout") == 0) { stdout_path = argv[argument_index + 1]; }
+		else { break; }
+	}
+	if (argc - argument_index < 2) {
+		fprintf(stderr, "usage: %s [--stdin <file>] [--stdout <file>] <label> <command> [args...]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	const char* label = argv[argument_index];
+	char** command = argv + argument_index + 1;
+
+	// NOTE: The child waits for a byte on this pipe before it calls exec, so that the counter is attached by the time it does.
+	int start_pipe[2];
+	if (pipe(start_pipe) == -1) { perror("pipe"); return EXIT_FAILURE; }
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	pid_t child = fork();
+	if (child == -1) { perror("fork"); return EXIT_FAILURE; }
+	if (child == 0) {
+		close(start_pipe[1]);
+		char start_byte;
+		if (read(start_pipe[0], &start_byte, 1) != 1) { _exit(127); }
+		close(start_pipe[0]);
+		if (stdin_path && !redirect(stdin_path, STDIN_FILENO, O_RDONLY)) { _exit(127); }
+		if (stdout_path && !redirect(stdout_path, STDOUT_FILENO, O_WRONLY | O_CREAT | O_TRUNC)) { _exit(127); }
+		execvp(command[0], command);
+		perror("execvp");
+		_exit(127);
+	}
+
+	close(start_pipe[0]);
+	int instruction_counter = open_instruction_counter(child);
+	if (write(start_pipe[1], "", 1) != 1) { perror("write"); }
+	close(start_pipe[1]);
+
+	int status;
+	struct rusage usage;
+	// NOTE: wait4 gives us the rusage of exactly this child, ru_maxrss is its peak resident set size in KiB.
+	if (wait4(child, &status, 0, &usage) == -1) { perror("wait4"); return EXIT_FAILURE; }
+
+	double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	int exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+	char instructions[32] = "";
+	uint64_t instruction_count;
+	if (instruction_counter != -1 && read(instruction_counter, &instruction_count, sizeof(instruction_count)) == sizeof(instruction_count)) {
+		snprintf(instructions, sizeof(instructions), "%llu", (unsigned long long)instruction_count);
+	}
+
+	printf("%s,%.3f,%ld,%d,%s\n", label, wall_seconds, usage.ru_maxrss, exit_status, instructions);
+	return exit_status;
+}
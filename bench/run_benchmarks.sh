@@ -0,0 +1,68 @@
+#!/bin/sh
+# Builds every workload with every engine, optimization level and bucket size, runs it and reports how that went.
+# Usage: run_benchmarks.sh <measure-binary> <work-dir> <workloads> <engines> <optimization-levels> <bucket-sizes> <input-size> <compiler-command...>
+#   workloads: "name:repetitions" pairs, the source is bench/workloads/<name>.b and it's run <repetitions> times per process
+#   engines: any of compiled, reserved, interpreted, jitted, lockstep (lockstep runs the repetitions 32 lanes at a time, see bench/workload.cpp)
+#   optimization-levels: O0, O3, etc., appended to the compiler command (so they override whatever -O it already contains)
+#   input-size: the workloads get this many bytes of text as stdin (only echo actually reads it)
+# The reserved engine doesn't use buckets, so it only runs once per optimization level (with an empty bucket_size).
+# The lockstep engine can't read input, so it skips the workloads that contain a ',' (there's no row for those).
+# Output: CSV with the header below. The run columns are empty if the build failed, instructions is empty without perf events.
+# NOTE: binary_size_bytes is the size of the whole (unstripped) executable.
+
+set -e
+
+MEASURE="$1"
+WORK_DIR="$2"
+WORKLOADS="$3"
+ENGINES="$4"
+OPTIMIZATION_LEVELS="$5"
+BUCKET_SIZES="$6"
+INPUT_SIZE="$7"
+shift 7
+
+INPUT_FILE="$WORK_DIR/workload_input.txt"
+awk -v size="$INPUT_SIZE" 'BEGIN {
+	line = "the quick brown fox jumps over the lazy dog 0123456789\n"
+	for (written = 0; written + length(line) <= size; written += length(line)) { printf "%s", line }
+}' > "$INPUT_FILE"
+
+echo "workload,engine,optimization_level,bucket_size,compile_seconds,compile_peak_rss_kib,binary_size_bytes,run_seconds,run_peak_rss_kib,instructions,exit_status"
+for WORKLOAD in $WORKLOADS; do
+	WORKLOAD_NAME="${WORKLOAD%%:*}"
+	REPETITIONS="${WORKLOAD#*:}"
+	WORKLOAD_DIR="$WORK_DIR/workload_$WORKLOAD_NAME"
+	mkdir -p "$WORKLOAD_DIR"
+	{ printf 'R"BF('; cat "bench/workloads/$WORKLOAD_NAME.b"; printf ')BF"\n'; } > "$WORKLOAD_DIR/workload.inc"
+
+	for ENGINE in $ENGINES; do
+		if [ "$ENGINE" = lockstep ] && grep -q ',' "bench/workloads/$WORKLOAD_NAME.b"; then continue; fi
+		ENGINE_DEFINE="-DBENCH_ENGINE_$(echo "$ENGINE" | tr '[:lower:]' '[:upper:]')"
+		ENGINE_BUCKET_SIZES="$BUCKET_SIZES"
+		if [ "$ENGINE" = reserved ]; then ENGINE_BUCKET_SIZES="-"; fi
+
+		for OPTIMIZATION_LEVEL in $OPTIMIZATION_LEVELS; do
+			for BUCKET_SIZE in $ENGINE_BUCKET_SIZES; do
+				BINARY="$WORKLOAD_DIR/${ENGINE}_${OPTIMIZATION_LEVEL}_$BUCKET_SIZE"
+				BUCKET_DEFINE=""
+				if [ "$BUCKET_SIZE" != "-" ]; then BUCKET_DEFINE="-DBENCH_BUCKET_SIZE=$BUCKET_SIZE"; else BUCKET_SIZE=""; fi
+
+				COMPILE_RESULT=$("$MEASURE" --stdout /dev/null compile "$@" "-$OPTIMIZATION_LEVEL" $ENGINE_DEFINE $BUCKET_DEFINE \
+					-I"$WORKLOAD_DIR" -o "$BINARY" bench/workload.cpp) || true
+				COMPILE_SECONDS=$(echo "$COMPILE_RESULT" | cut -d, -f2)
+				COMPILE_RSS=$(echo "$COMPILE_RESULT" | cut -d, -f3)
+				COMPILE_STATUS=$(echo "$COMPILE_RESULT" | cut -d, -f4)
+
+				ROW="$WORKLOAD_NAME,$ENGINE,$OPTIMIZATION_LEVEL,$BUCKET_SIZE,$COMPILE_SECONDS,$COMPILE_RSS"
+				if [ "$COMPILE_STATUS" != 0 ]; then
+					echo "$ROW,,,,,$COMPILE_STATUS"
+					continue
+				fi
+
+				BINARY_SIZE=$(wc -c < "$BINARY" | tr -d ' ')
+				RUN_RESULT=$("$MEASURE" --stdin "$INPUT_FILE" --stdout /dev/null run "$BINARY" "$REPETITIONS") || true
+				echo "$ROW,$BINARY_SIZE,$(echo "$RUN_RESULT" | cut -d, -f2),$(echo "$RUN_RESULT" | cut -d, -f3),$(echo "$RUN_RESULT" | cut -d, -f5),$(echo "$RUN_RESULT" | cut -d, -f4)"
+			done
+		done
+	done
+done
@@ -0,0 +1,77 @@
+// Runtime benchmark: runs one brainfuck workload (workload.inc, which is a raw string literal made from bench/workloads/<name>.b).
+// The engine is picked with BENCH_ENGINE_COMPILED, BENCH_ENGINE_RESERVED, BENCH_ENGINE_INTERPRETED, BENCH_ENGINE_JITTED or BENCH_ENGINE_LOCKSTEP,
+// the bucket size with BENCH_BUCKET_SIZE. See bench/run_benchmarks.sh.
+// NOTE: The lockstep engine runs the repetitions BENCH_LOCKSTEP_LANE_COUNT at a time (the last batch only uses as many lanes as are left),
+// so it runs exactly as many instances as the others. It doesn't read any input, so leave input-reading workloads out of its runs.
+// Usage: workload [repetitions]
+// Input comes from stdin (EOF reads as 0, so ",[.,]" stops at the end of the input), output goes to stdout.
+// Exits with 0 if every repetition returned SUCCESS.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "meta_brainfuck_compiler.h"
+
+#ifndef BENCH_BUCKET_SIZE
+#define BENCH_BUCKET_SIZE META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT
+#endif
+
+#ifndef BENCH_LOCKSTEP_LANE_COUNT
+#define BENCH_LOCKSTEP_LANE_COUNT 32
+#endif
+
+static constexpr const char* source_code =
+#include "workload.inc"
+;
+
+// NOTE: Macros instead of variables because META_COMPILE_BRAINFUCK needs the lambdas inline.
+#define BENCH_INPUT_FUNCTOR []() -> uint16_t { \
+	int character = getchar_unlocked(); \
+	return character == EOF ? 0 : (uint16_t)character; \
+}
+#define BENCH_OUTPUT_FUNCTOR [](const uint8_t* data, size_t length) -> bool { return fwrite(data, 1, length, stdout) == length; }
+
+template <typename program_t>
+static int run_repeatedly(program_t& program, unsigned long repetitions) {
+	for (unsigned long i = 0; i < repetitions; i++) {
+		if (program.run() != meta::brainfuck_run_return_t::SUCCESS) { return EXIT_FAILURE; }
+		if (!program.reset_state_keep_vec_reserved()) { return EXIT_FAILURE; }
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+	unsigned long repetitions = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1;
+
+#if defined(BENCH_ENGINE_COMPILED)
+	auto program = META_COMPILE_BRAINFUCK_WITH_CUSTOM_BUCKET_INC_SIZE(source_code, BENCH_INPUT_FUNCTOR, BENCH_OUTPUT_FUNCTOR, BENCH_BUCKET_SIZE);
+	return run_repeatedly(program, repetitions);
+#elif defined(BENCH_ENGINE_RESERVED)
+	auto program = META_COMPILE_BRAINFUCK_WITH_RESERVED_TAPE(source_code, BENCH_INPUT_FUNCTOR, BENCH_OUTPUT_FUNCTOR);
+	return run_repeatedly(program, repetitions);
+#elif defined(BENCH_ENGINE_LOCKSTEP)
+	meta::lockstep_brainfuck_t<source_code, BENCH_LOCKSTEP_LANE_COUNT, BENCH_BUCKET_SIZE> program;
+	for (unsigned long i = 0; i < repetitions; i += BENCH_LOCKSTEP_LANE_COUNT) {
+		size_t running_lane_count = repetitions - i < BENCH_LOCKSTEP_LANE_COUNT ? repetitions - i : BENCH_LOCKSTEP_LANE_COUNT;
+		if (!program.run(running_lane_count)) { return EXIT_FAILURE; }
+		for (size_t lane = 0; lane < running_lane_count; lane++) {
+			if (program.lane_return_values[lane] != meta::brainfuck_run_return_t::SUCCESS) { return EXIT_FAILURE; }
+			if (fwrite(program.lane_outputs[lane].data, 1, program.lane_outputs[lane].length, stdout) != program.lane_outputs[lane].length) { return EXIT_FAILURE; }
+		}
+		if (!program.reset_state_keep_vec_reserved()) { return EXIT_FAILURE; }
+	}
+	return EXIT_SUCCESS;
+#elif defined(BENCH_ENGINE_INTERPRETED) || defined(BENCH_ENGINE_JITTED)
+	auto read_input_byte = BENCH_INPUT_FUNCTOR;
+	auto write_output_bytes = BENCH_OUTPUT_FUNCTOR;
+#if defined(BENCH_ENGINE_INTERPRETED)
+	meta::interpreted_brainfuck_t<decltype(read_input_byte), decltype(write_output_bytes), BENCH_BUCKET_SIZE> program(read_input_byte, write_output_bytes);
+#else
+	meta::jitted_brainfuck_t<decltype(read_input_byte), decltype(write_output_bytes), BENCH_BUCKET_SIZE> program(read_input_byte, write_output_bytes);
+#endif
+	if (program.load(source_code) != meta::ir::parse_error_t::NONE) { return EXIT_FAILURE; }
+	return run_repeatedly(program, repetitions);
+#else
+#error "bench/workload.cpp: define one of BENCH_ENGINE_COMPILED, BENCH_ENGINE_RESERVED, BENCH_ENGINE_INTERPRETED, BENCH_ENGINE_JITTED or BENCH_ENGINE_LOCKSTEP"
+#endif
+}
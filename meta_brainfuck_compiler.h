@@ -1,11 +1,39 @@
 #pragma once
 
 #define META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT (1024 * 4)
+// NOTE: Only used by the batched I/O functors, see compiled_brainfuck_t.
+#define META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT (1024 * 4)
+// NOTE: Only address space, see helpers::reserved_vector. Physical memory is only used for the pages that the program actually touches.
+#define META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT ((size_t)1024 * 1024 * 1024 * 4)
 
 #include <new>
 #include <cstdint>
 #include <utility>
 #include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <cstdio>
+#include <type_traits>
+#include <atomic>
+#include <memory>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define META_BRAINFUCK_COMPILER_HAS_RESERVED_TAPE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if __has_include(<pthread.h>) && __has_include(<unistd.h>)
+#define META_BRAINFUCK_COMPILER_HAS_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// NOTE: The JIT only knows how to generate x86-64 code with the System V calling convention.
+#if defined(META_BRAINFUCK_COMPILER_HAS_RESERVED_TAPE) && defined(__x86_64__) && defined(__linux__)
+#define META_BRAINFUCK_COMPILER_HAS_JIT
+#endif
 
 namespace meta {
 
@@ -19,7 +47,7 @@ namespace meta {
 	   through possible, but that would just overcomplicate things given that there is a simple alternative:
 	   	--> If you want to step through your brainfuck programs, simply use a brainfuck interpreter instead of a brainfuck
 		compiler. It's trivially integratable into an interpreter so why not just do that?
-		I'll build an interpreter and put a debugger mode in it. (TODO)
+		There's an interpreter now (interpreted_brainfuck_t, further down), the debugger mode for it is still a TODO.
 	*/
 
 	/*
@@ -58,6 +86,20 @@ Since references don't have the restrictions when it comes to their targets. Ver
 				data(other.data), bucket_length(other.bucket_length), length(other.length)
 			{
 				other.data = nullptr;
+				other.bucket_length = 0;
+				other.length = 0;
+			}
+
+			non_bad_vector& operator=(non_bad_vector&& other) noexcept {
+				if (this == &other) { return *this; }
+				reset_everything();
+				data = other.data;
+				bucket_length = other.bucket_length;
+				length = other.length;
+				other.data = nullptr;
+				other.bucket_length = 0;
+				other.length = 0;
+				return *this;
 			}
 
 			static non_bad_vector create_nulled_out_vec(size_t length) {
@@ -112,6 +154,17 @@ Since references don't have the restrictions when it comes to their targets. Ver
 				return true;
 			}
 
+			// NOTE: Same as calling push_back(0) amount times, except there's only one (potential) reallocation.
+			// We still allocate in multiples of bucket_size, so the allocation pattern stays the same as with push_back.
+			bool push_back_nulled_out(size_t amount) noexcept {
+				if (length + amount > bucket_length) {
+					size_t missing_amount = length + amount - bucket_length;
+					if (!push_uninitialized_mem(((missing_amount + bucket_size - 1) / bucket_size) * bucket_size)) { return false; }
+				}
+				for (size_t i = 0; i < amount; i++) { new (data + length++) element_t(0); }
+				return true;
+			}
+
 			const element_t& operator[](size_t index) const noexcept { return data[index]; }
 			element_t& operator[](size_t index) noexcept { return data[index]; }
 
@@ -152,217 +205,3121 @@ Since references don't have the restrictions when it comes to their targets. Ver
 			}
 		};
 
-	}
+#ifdef META_BRAINFUCK_COMPILER_HAS_RESERVED_TAPE
+		/*
+		   Alternative to non_bad_vector, for when you don't want to pay for growing the vector.
+		   Instead of allocating as we go, we reserve one big region of virtual memory up front. The kernel only gives us
+		   actual (zeroed) pages once we touch them, so reserving a couple of GiB doesn't cost anything except address space.
+		   The layout looks like this:
+		   	[guard page][slack][reserved_length elements][slack][guard page]
+		   The slack regions are readable and writable. They exist because the compiled code doesn't check every pointer move
+		   when it uses this vector, it only checks at certain checkpoints (see ir::annotate_checkpoint_ranges). In between checkpoints,
+		   the pointer can move at most slack_length elements out of bounds, so it always lands in the slack and we can still
+		   report the error at the next checkpoint instead of segfaulting. The guard pages are just there so that we crash instead of
+		   silently corrupting memory if that assumption is ever wrong.
+		   NOTE: Since nothing ever gets reallocated, the data pointer stays the same for the whole lifetime of the mapping.
+		*/
+		template <typename element_t, size_t reserved_length, size_t slack_length>
+		class reserved_vector {
+			// NOTE: Cells between checkpoints are accessed without us starting their lifetime first (that's the whole point),
+			// which is only fine for trivial types (they're implicit-lifetime types).
+			static_assert(std::is_trivial<element_t>::value, "reserved_vector only supports trivial element types");
 
-	enum class brainfuck_run_return_t : uint8_t {
-		ALLOCATION_FAILURE,
-		SUCCESS,
-		INPUT_FAILURE,
-		OUTPUT_FAILURE
-	};
+			static size_t page_size() noexcept { return (size_t)sysconf(_SC_PAGESIZE); }
 
-	template <typename A_t, typename B_t>
-	struct are_types_same { consteval operator bool() const { return false; } };
+			static size_t round_to_pages(size_t size) noexcept { return (size + page_size() - 1) / page_size() * page_size(); }
 
-	template <typename A_t>
-	struct are_types_same<A_t, A_t> { consteval operator bool() const { return true; } };
+			static size_t slack_size() noexcept { return round_to_pages(slack_length * sizeof(element_t)); }
 
-	template <typename T, typename conduit_t>
-	struct is_invokable_through { };
+			static size_t mapping_size() noexcept { return page_size() + slack_size() + round_to_pages(reserved_length * sizeof(element_t)) + slack_size() + page_size(); }
 
-	template <typename T, typename conduit_ret_t, typename... conduit_param_types>
-	struct is_invokable_through<T, conduit_ret_t(conduit_param_types...)> {
-	private:
-		using yes_ret_t = char[2];
-		using no_ret_t = char[1];
+			uint8_t* mapping_begin() const noexcept { return (uint8_t*)data - slack_size() - page_size(); }
 
-		template <typename U, typename ret_t, typename... param_types, 
-			 typename std::enable_if<are_types_same<decltype((*(U*)nullptr)((*(param_types*)nullptr)...)), ret_t> { }, bool>::type = true>
-		consteval yes_ret_t& filter(void*) const;
+			bool map() noexcept {
+				void* mapping = mmap(nullptr, mapping_size(), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+				if (mapping == MAP_FAILED) { return false; }
+				if (mprotect((uint8_t*)mapping + page_size(), mapping_size() - 2 * page_size(), PROT_READ | PROT_WRITE) != 0) {
+					munmap(mapping, mapping_size());
+					return false;
+				}
+				data = (element_t*)((uint8_t*)mapping + page_size() + slack_size());
+				return true;
+			}
 
-		// NOTE: Apparently only funcs with templated definitions are considered in overload resolution, so we have to put this here.
-		template <typename U, typename ret_t, typename... param_types>
-		consteval no_ret_t& filter(...) const;
+		public:
+			element_t* data = nullptr;
+			size_t length = 0;
 
-	public:
-		consteval operator bool() const { return sizeof(filter<T, conduit_ret_t, conduit_param_types...>(nullptr)) == sizeof(yes_ret_t); }
-	};
+			static constexpr size_t capacity = reserved_length;
 
-	template <const char * const& source_code_const_string_original, typename input_functor_t, typename output_functor_t, size_t data_vector_bucket_size, 
-		 // NOTE: Doesn't care if the functions are noexcept or not, which is fine since that doesn't matter for us in this case.
-		 // NOTE: Also doesn't give any thought to whether they're const or anything, which is also fine since that doesn't concern us.
-		 typename std::enable_if<is_invokable_through<input_functor_t, uint16_t()> { } &&
-			 is_invokable_through<output_functor_t, bool(uint8_t)> { }, bool>::type = true>
-	class compiled_brainfuck_t {
-	public:
-		helpers::non_bad_vector<uint8_t, data_vector_bucket_size> data = helpers::non_bad_vector<uint8_t, data_vector_bucket_size>::create_nulled_out_vec(1);
-		uint8_t* data_end_ptr = data.data + data.length;
-		uint8_t* data_ptr = data.data;
+			consteval reserved_vector() = default;
 
-		input_functor_t read_input_byte;
-		output_functor_t write_output_byte;
+			reserved_vector(const reserved_vector& other) = delete;
 
-		compiled_brainfuck_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback) : read_input_byte(read_input_byte_callback), write_output_byte(write_output_byte_callback) { }
+			constexpr reserved_vector(reserved_vector&& other) noexcept : data(other.data), length(other.length) {
+				other.data = nullptr;
+				other.length = 0;
+			}
 
-		consteval compiled_brainfuck_t(compiled_brainfuck_t<source_code_const_string_original, input_functor_t, output_functor_t, data_vector_bucket_size>&& other) : 
-			data(std::move(other.data)), data_ptr(other.data_ptr), data_end_ptr(other.data_end_ptr), 
-			read_input_byte(other.read_input_byte), write_output_byte(other.write_output_byte)
-		{ }
+			reserved_vector& operator=(reserved_vector&& other) noexcept {
+				if (this == &other) { return *this; }
+				reset_everything();
+				data = other.data;
+				length = other.length;
+				other.data = nullptr;
+				other.length = 0;
+				return *this;
+			}
 
-		// NOTE: I forgot when this is going to be introduced, but I remember that this should (eventually) imply
-		// that the copy assignment operator is also deleted. So this one line does everything we need it to.
-		compiled_brainfuck_t(const compiled_brainfuck_t& other) = delete;
+			static reserved_vector create_nulled_out_vec(size_t length) {
+				reserved_vector result;
+				if (length > capacity || !result.map()) { return result; }
+				result.length = length;
+				return result;
+			}
 
-		bool increment_data_ptr() noexcept {
-			if (++data_ptr == data_end_ptr) {
-				if (!data.push_back(0)) { return false; }
+			// NOTE: The memory is already zeroed out by the kernel, so we don't have to do anything except count.
+			bool push_back_nulled_out(size_t amount) noexcept {
+				if (!data && !map()) { return false; }
+				if (amount > capacity - length) { return false; }
+				length += amount;
+				return true;
+			}
+
+			template <typename element_ref_t>
+			bool push_back(element_ref_t&& new_element) noexcept {
+				if (!push_back_nulled_out(1)) { return false; }
+				data[length - 1] = std::forward<element_ref_t>(new_element);
+				return true;
+			}
+
+			const element_t& operator[](size_t index) const noexcept { return data[index]; }
+			element_t& operator[](size_t index) noexcept { return data[index]; }
+
+			// NOTE: The program might have written to the slack (or past length in general) before it got caught,
+			// so we zero out everything that could have possibly been touched, not just [0, length).
+			void release_length_keep_reserve() noexcept {
+				if (!data) { length = 0; return; }
+				size_t touched_length = length + slack_length > capacity ? capacity : length + slack_length;
+				memset((uint8_t*)data - slack_size(), 0, slack_size() + touched_length * sizeof(element_t));
+				if (length + slack_length > capacity) { memset(data + capacity, 0, slack_size()); }
+				length = 0;
+			}
+
+			// NOTE: Unmapping gives all the pages back to the system. push_back maps a fresh region again on demand.
+			void reset_everything() noexcept {
+				if (data) { munmap(mapping_begin(), mapping_size()); }
+				data = nullptr;
+				length = 0;
+			}
+
+			~reserved_vector() { if (data) { munmap(mapping_begin(), mapping_size()); } }
+		};
+#endif
+
+		template <size_t size>
+		struct io_buffer_t {
+			uint8_t data[size];
+			size_t position = 0;
+			size_t length = 0;
+		};
+
+		// NOTE: Stands in for the I/O buffers when they aren't needed. Together with [[no_unique_address]], it doesn't take up any space.
+		struct empty_t { };
+
+		// NOTE: Returns nullptr if there is no zero in the range.
+		inline uint8_t* find_zero_forward(uint8_t* begin, uint8_t* end) noexcept {
+			return (uint8_t*)memchr(begin, 0, end - begin);
+		}
+
+		inline uint8_t* find_zero_backward(uint8_t* begin, uint8_t* end) noexcept {
+#ifdef __GLIBC__
+			return (uint8_t*)memrchr(begin, 0, end - begin);
+#else
+			while (end != begin) { if (*--end == 0) { return end; } }
+			return nullptr;
+#endif
+		}
+
+		/*
+		   This is what a folded run of '>' and '<' turns into, in every engine. Instead of one check per character,
+		   we only check the left edge once and grow the vector once (if necessary) for the whole run.
+		   [data_ptr + min, data_ptr + max] has to be on the tape, the pointer then moves by delta.
+		   Growing can reallocate the tape, that's why the pointers are passed by reference.
+		*/
+		template <typename data_vector_t>
+		inline bool move_data_ptr(data_vector_t& data, uint8_t*& data_ptr, uint8_t*& data_end_ptr, ptrdiff_t delta, ptrdiff_t min, ptrdiff_t max) noexcept {
+			if (min < 0 && data_ptr - data.data < -min) { return false; }
+			if (max > 0 && data_end_ptr - data_ptr <= max) {
+				size_t data_ptr_index = data_ptr - data.data;
+				if (!data.push_back_nulled_out(data_ptr_index + max + 1 - data.length)) { return false; }
 				data_end_ptr = data.data + data.length;
-				data_ptr = data_end_ptr - 1;
+				data_ptr = data.data + data_ptr_index;
 			}
+			data_ptr += delta;
 			return true;
 		}
 
-		bool decrement_data_ptr() noexcept {
-			// NOTE: We have to do it like this to avoid pointer underflow/overflow, which is super duper UB.
-			if (data_ptr == data.data) { return false; }
-			data_ptr--;
-			return true;
+		// NOTE: "[>]" on a tape that grows (the pointer's cell isn't 0).
+		// Everything past the end is implicitly zero, so if there's no zero on the tape, the first zero is the first cell that doesn't exist yet.
+		template <typename data_vector_t>
+		inline bool scan_right(data_vector_t& data, uint8_t*& data_ptr, uint8_t*& data_end_ptr) noexcept {
+			uint8_t* zero_ptr = find_zero_forward(data_ptr, data_end_ptr);
+			if (zero_ptr) { data_ptr = zero_ptr; return true; }
+			data_ptr = data_end_ptr - 1;
+			return move_data_ptr(data, data_ptr, data_end_ptr, 1, 0, 1);
+		}
+
+		// NOTE: A multiply loop runs until the origin hits 0, so with a delta of -1 it runs origin times and with +1 it runs (256 - origin) times.
+		constexpr uint8_t multiply_loop_iterations(int8_t origin_delta, uint8_t origin) noexcept {
+			return origin_delta == -1 ? origin : (uint8_t)-origin;
 		}
 
+	}
+
+	/*
+	   Before we generate any code, the source gets parsed into a flat array of instructions (the IR).
+	   This happens in a constexpr context, so for compile-time sources it's completely free at runtime.
+	   Having the IR has two big advantages over generating code straight from the characters:
+	   	--> Comments and other non-command characters just disappear during parsing, so they don't cost anything.
+		--> Every loop knows where its end is (jump), so the code generator doesn't have to recurse once per character
+		to find it. The instantiation depth is now bounded by the loop nesting depth instead of by the source length.
+	   It also gives us a nice place to put optimization passes, which all operate on the IR.
+	*/
+	namespace ir {
+
+		enum class op_t : uint8_t {
+			END,
+			// NOTE: value is the (wrapping) delta for the current cell.
+			ADD,
+			// NOTE: value is the pointer delta, min and max are the lowest and highest offset the pointer passes through.
+			MOVE,
+			INPUT,
+			OUTPUT,
+			// NOTE: jump is the index of the matching LOOP_END and vice versa.
+			// For LOOP_BEGIN, value is 1 if the loop is balanced, min and max are then the range of cells it can touch (see annotate_balanced_loops).
+			LOOP_BEGIN,
+			LOOP_END,
+			// NOTE: value is the origin delta (+1 or -1), min and max are the range of the targets,
+			// jump is the index right after the last MULTIPLY_ADD belonging to this loop.
+			MULTIPLY_LOOP,
+			// NOTE: offset is the target cell (relative to the origin), value is the per-iteration delta.
+			MULTIPLY_ADD,
+			SCAN_RIGHT,
+			SCAN_LEFT
+		};
+
+		struct instruction_t {
+			op_t op = op_t::END;
+			int64_t value = 0;
+			ptrdiff_t offset = 0;
+			ptrdiff_t min = 0;
+			ptrdiff_t max = 0;
+			size_t jump = 0;
+			// NOTE: Only used by checkpoints (see annotate_checkpoint_ranges). It's the range of cells that was touched since
+			// the previous checkpoint, relative to the pointer at this checkpoint.
+			ptrdiff_t checked_min = 0;
+			ptrdiff_t checked_max = 0;
+			// NOTE: Offset of the first source character that this instruction was created from.
+			size_t src_offset = 0;
+		};
+
+		enum class parse_error_t : uint8_t {
+			NONE,
+			UNMATCHED_LOOP_END,
+			UNMATCHED_LOOP_BEGIN,
+			ALLOCATION_FAILURE
+		};
+
 		/*
-		   NOTE: You've been wondering why compiled switch statements (on my x86-64 machine)
-		   choose to load a target addr from memory and slow jump to that instead of slow jumping to an addr
-		   at a specific offset, which contains a fast (unconditional) jump to the target code.
-		   Basically it comes down to this question: Is a fast jump of memory access faster?
-		   Apparently, at least on my machine, memory access must be faster, or else this optimization wouldn't be done.
-		   I've done some research, and when the L1 cache is hit (which I guess is what the compiler is optimizing for here),
-		   the access time is just a tiny tad bit slower than talking to a register, so it's unbelievably fast.
-		   You might think fast jumps are faster because they must only take like 1 clock cycle right?
-		   That's not actually true, they can be slow (and I guess they are slower than L1 cache hits most of the time),
-		   since because of the way the CPU is pipelined, the CPU doesn't actually know if the jump instruction is
-		   conditional or unconditional when it first enters the pipe, it takes a few stages till it definitively figures that out.
-		   That means it still has to use the branch predictor, even for fast jumps, since it needs to keep fetching instructions
-		   somewhere and it has no other option than to predict where until it can correct.
-		   This adds overhead and makes even a fast jump undesirable in the face of a perfect memory access.
+		   Growable instruction array that works in constant evaluation as well as at runtime.
+		   In constant evaluation we have to use std::allocator (the allocations are transient, they never leave the evaluation),
+		   at runtime we use realloc so we can report allocation failures instead of crashing (we compile with -fno-exceptions).
+		   NOTE: std::allocator instead of new[] because new[] initializes the whole array, which counts against the constexpr evaluation limits
+		   for every element, used or not. With the allocator, only the elements that actually get pushed are constructed.
 		*/
+		class instruction_buffer_t {
+		public:
+			instruction_t* data = nullptr;
+			size_t length = 0;
+			size_t capacity = 0;
+			parse_error_t error = parse_error_t::NONE;
 
-		template <const char * const& source_code_const_string, size_t src_offset, size_t baseline_depth, size_t depth>
-		brainfuck_run_return_t loop_skip() noexcept {
-			constexpr const char* source_code_ptr = source_code_const_string + src_offset;
+			constexpr instruction_buffer_t() = default;
 
-			if constexpr (*source_code_ptr == '[') { return loop_skip<source_code_const_string, src_offset + 1, baseline_depth, depth + 1>(); }
+			instruction_buffer_t(const instruction_buffer_t& other) = delete;
 
-			else if constexpr (*source_code_ptr == ']') {
-				if constexpr (depth == baseline_depth) { return inner_run<source_code_const_string, src_offset + 1, baseline_depth - 1>(); }
-				else { return loop_skip<source_code_const_string, src_offset + 1, baseline_depth, depth - 1>(); }
+			constexpr instruction_buffer_t(instruction_buffer_t&& other) noexcept : 
+				data(other.data), length(other.length), capacity(other.capacity), error(other.error)
+			{
+				other.data = nullptr;
+				other.length = 0;
+				other.capacity = 0;
 			}
 
-			else {
-				static_assert(*source_code_ptr != '\0', "brainfuck compilation failed: '[' character did not posess a succeeding ']' character");
-				return loop_skip<source_code_const_string, src_offset + 1, baseline_depth, depth>();
+			constexpr instruction_buffer_t& operator=(instruction_buffer_t&& other) noexcept {
+				release();
+				data = other.data;
+				length = other.length;
+				capacity = other.capacity;
+				error = other.error;
+				other.data = nullptr;
+				other.length = 0;
+				other.capacity = 0;
+				return *this;
+			}
+
+			// NOTE: Passes that know how long their result is going to be (roughly) reserve up front, which saves copying everything around while growing.
+			constexpr bool reserve(size_t new_capacity) noexcept {
+				if (new_capacity <= capacity) { return true; }
+				if (std::is_constant_evaluated()) {
+					std::allocator<instruction_t> allocator;
+					instruction_t* new_data = allocator.allocate(new_capacity);
+					for (size_t i = 0; i < length; i++) { std::construct_at(new_data + i, data[i]); }
+					if (data) { allocator.deallocate(data, capacity); }
+					data = new_data;
+				} else {
+					instruction_t* new_data = (instruction_t*)realloc(data, new_capacity * sizeof(instruction_t));
+					if (!new_data) { error = parse_error_t::ALLOCATION_FAILURE; return false; }
+					data = new_data;
+				}
+				capacity = new_capacity;
+				return true;
+			}
+
+			constexpr bool push_back(const instruction_t& instruction) noexcept {
+				if (length == capacity && !reserve(capacity == 0 ? 64 : capacity * 2)) { return false; }
+				std::construct_at(data + length++, instruction);
+				return true;
+			}
+
+			constexpr const instruction_t& operator[](size_t index) const noexcept { return data[index]; }
+			constexpr instruction_t& operator[](size_t index) noexcept { return data[index]; }
+
+			constexpr void release() noexcept {
+				if (std::is_constant_evaluated()) { if (data) { std::allocator<instruction_t>().deallocate(data, capacity); } }
+				else { free(data); }
+				data = nullptr;
+				length = 0;
+				capacity = 0;
+			}
+
+			constexpr ~instruction_buffer_t() { release(); }
+		};
+
+		constexpr bool is_brainfuck_command(char character) {
+			switch (character) {
+			case '>': case '<': case '+': case '-': case '[': case ']': case ',': case '.': return true;
+			default: return false;
 			}
 		}
 
-		template <const char * const& source_code_const_string, size_t src_offset, size_t depth>
-		brainfuck_run_return_t inner_run() noexcept {
-			constexpr const char* source_code_ptr = source_code_const_string + src_offset;
+		// NOTE: Folds the run of '+'/'-' (or '>'/'<') that starts at source_position into one instruction and advances
+		// source_position to the next command that doesn't belong to the run. Comments in between don't break up a run.
+		constexpr instruction_t fold_data_run(std::string_view source, size_t& source_position) {
+			instruction_t result { .op = op_t::ADD, .src_offset = source_position };
+			for (; source_position < source.length(); source_position++) {
+				char character = source[source_position];
+				if (character == '+') { result.value++; continue; }
+				if (character == '-') { result.value--; continue; }
+				if (is_brainfuck_command(character)) { break; }
+			}
+			result.value = (uint8_t)result.value;
+			return result;
+		}
 
-			if constexpr (*source_code_ptr == '>') {
-				if (!increment_data_ptr()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+		// NOTE: We need min and max because something like "<>" at cell 0 has a delta of 0 but still has to fail,
+		// same as in the unfolded version.
+		constexpr instruction_t fold_pointer_run(std::string_view source, size_t& source_position) {
+			instruction_t result { .op = op_t::MOVE, .src_offset = source_position };
+			for (; source_position < source.length(); source_position++) {
+				char character = source[source_position];
+				if (character == '>') { if (++result.value > result.max) { result.max = result.value; } continue; }
+				if (character == '<') { if (--result.value < result.min) { result.min = result.value; } continue; }
+				if (is_brainfuck_command(character)) { break; }
 			}
+			return result;
+		}
 
-			else if constexpr (*source_code_ptr == '<') {
-				if (!decrement_data_ptr()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+		// NOTE: Recalculates all the jump targets. Passes that add or remove instructions just call this at the end
+		// instead of having to keep track of everything themselves.
+		constexpr parse_error_t link_loops(instruction_buffer_t& program) {
+			size_t depth = 0;
+			for (size_t i = 0; i < program.length; i++) {
+				if (program[i].op == op_t::LOOP_BEGIN) { depth++; }
+				else if (program[i].op == op_t::LOOP_END) { if (depth-- == 0) { return parse_error_t::UNMATCHED_LOOP_END; } }
 			}
+			if (depth != 0) { return parse_error_t::UNMATCHED_LOOP_BEGIN; }
 
-			// NOTE: Don't worry, the brainfuck program can totally overflow the data values without causing UB. It's ok.
-			else if constexpr (*source_code_ptr == '+') {
-				(*data_ptr)++;
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+			// NOTE: Open loops are chained together through their jump fields, that way we don't need a separate stack.
+			size_t open_loop = (size_t)-1;
+			for (size_t i = 0; i < program.length; i++) {
+				if (program[i].op == op_t::LOOP_BEGIN) { program[i].jump = open_loop; open_loop = i; }
+				else if (program[i].op == op_t::LOOP_END) {
+					size_t loop_begin = open_loop;
+					open_loop = program[loop_begin].jump;
+					program[loop_begin].jump = i;
+					program[i].jump = loop_begin;
+				}
+				else if (program[i].op == op_t::MULTIPLY_LOOP) {
+					size_t end = i + 1;
+					while (end < program.length && program[end].op == op_t::MULTIPLY_ADD) { end++; }
+					program[i].jump = end;
+				}
 			}
+			return parse_error_t::NONE;
+		}
 
-			else if constexpr (*source_code_ptr == '-') {
-				(*data_ptr)--;
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+		constexpr instruction_buffer_t parse(std::string_view source) {
+			instruction_buffer_t result;
+			size_t source_position = 0;
+			while (source_position < source.length()) {
+				char character = source[source_position];
+				instruction_t instruction { .src_offset = source_position };
+				switch (character) {
+				case '+': case '-':
+					instruction = fold_data_run(source, source_position);
+					if (instruction.value == 0) { continue; }
+					break;
+				case '>': case '<':
+					instruction = fold_pointer_run(source, source_position);
+					if (instruction.min == 0 && instruction.max == 0) { continue; }
+					break;
+				case '[': instruction.op = op_t::LOOP_BEGIN; source_position++; break;
+				case ']': instruction.op = op_t::LOOP_END; source_position++; break;
+				case ',': instruction.op = op_t::INPUT; source_position++; break;
+				case '.': instruction.op = op_t::OUTPUT; source_position++; break;
+				default: source_position++; continue;
+				}
+				if (!result.push_back(instruction)) { return result; }
 			}
+			if (!result.push_back(instruction_t { .op = op_t::END, .src_offset = source.length() })) { return result; }
+			result.error = link_loops(result);
+			return result;
+		}
 
-			else if constexpr (*source_code_ptr == '[') {
-				while (*data_ptr != 0) {
-					brainfuck_run_return_t return_value = inner_run<source_code_const_string, src_offset + 1, depth + 1>();
-					if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+		/*
+		   Loop idioms are loops that we can replace with closed-form code. We only look at loops that consist of nothing but
+		   ADD and MOVE instructions, since everything else is way too hard to reason about (and usually not worth it anyway).
+		   	--> MULTIPLY_LOOP: The body is balanced (the pointer ends up where it started) and changes the origin by exactly +1 or -1.
+			That means we know how many iterations the loop is going to do, and every other touched cell just gets
+			(iterations * per-iteration-delta) added onto it. "[-]" and "[+]" are simply multiply loops without any targets.
+			--> SCAN_RIGHT/SCAN_LEFT: "[>]" and "[<]", which search for the nearest zero cell. These we can do with memchr,
+			which is vectorized in pretty much every libc out there.
+		*/
+		constexpr bool try_emit_loop_idiom(const instruction_buffer_t& program, size_t loop_begin, instruction_buffer_t& result) {
+			size_t loop_end = program[loop_begin].jump;
+			size_t body_begin = loop_begin + 1;
+			for (size_t i = body_begin; i < loop_end; i++) { if (program[i].op != op_t::ADD && program[i].op != op_t::MOVE) { return false; } }
+
+			if (loop_end - body_begin == 1 && program[body_begin].op == op_t::MOVE) {
+				const instruction_t& move = program[body_begin];
+				instruction_t scan { .src_offset = program[loop_begin].src_offset };
+				if (move.value == 1 && move.min == 0 && move.max == 1) { scan.op = op_t::SCAN_RIGHT; }
+				else if (move.value == -1 && move.min == -1 && move.max == 0) { scan.op = op_t::SCAN_LEFT; }
+				else { return false; }
+				return result.push_back(scan);
+			}
+
+			instruction_t multiply_loop { .op = op_t::MULTIPLY_LOOP, .src_offset = program[loop_begin].src_offset };
+			ptrdiff_t offset = 0;
+			uint8_t origin_delta = 0;
+			for (size_t i = body_begin; i < loop_end; i++) {
+				if (program[i].op == op_t::MOVE) {
+					if (offset + program[i].min < multiply_loop.min) { multiply_loop.min = offset + program[i].min; }
+					if (offset + program[i].max > multiply_loop.max) { multiply_loop.max = offset + program[i].max; }
+					offset += program[i].value;
 				}
-				constexpr size_t new_depth = depth + 1;
-				return loop_skip<source_code_const_string, src_offset + 1, new_depth, new_depth>();
+				else if (offset == 0) { origin_delta += program[i].value; }
 			}
+			if (offset != 0 || (origin_delta != 1 && origin_delta != (uint8_t)-1)) { return false; }
+			multiply_loop.value = origin_delta == 1 ? 1 : -1;
+			if (!result.push_back(multiply_loop)) { return false; }
 
-			else if constexpr (*source_code_ptr == ']') {
-				static_assert(depth != 0, "brainfuck compilation failed: ']' character did not posess a preceding '[' character");
-				return brainfuck_run_return_t::SUCCESS;
+			// NOTE: Every target only gets one MULTIPLY_ADD, even if the body touches it multiple times.
+			size_t targets_begin = result.length;
+			offset = 0;
+			for (size_t i = body_begin; i < loop_end; i++) {
+				if (program[i].op == op_t::MOVE) { offset += program[i].value; continue; }
+				if (offset == 0) { continue; }
+				size_t target = targets_begin;
+				for (; target < result.length; target++) { if (result[target].offset == offset) { break; } }
+				if (target == result.length) {
+					if (!result.push_back(instruction_t { .op = op_t::MULTIPLY_ADD, .offset = offset, .src_offset = program[i].src_offset })) { return false; }
+				}
+				result[target].value = (uint8_t)(result[target].value + program[i].value);
+			}
+			return true;
+		}
+
+		constexpr instruction_buffer_t recognize_loop_idioms(const instruction_buffer_t& program) {
+			instruction_buffer_t result;
+			if (!result.reserve(program.length)) { return result; }
+			for (size_t i = 0; i < program.length; i++) {
+				if (program[i].op == op_t::LOOP_BEGIN) {
+					size_t previous_length = result.length;
+					if (try_emit_loop_idiom(program, i, result)) { i = program[i].jump; continue; }
+					if (result.error != parse_error_t::NONE) { return result; }
+					// NOTE: A failed attempt might have left a half-emitted idiom behind.
+					result.length = previous_length;
+				}
+				if (!result.push_back(program[i])) { return result; }
 			}
-			
-			else if constexpr (*source_code_ptr == ',') {
-				uint16_t input_result = read_input_byte();
-				if (input_result == (uint16_t)-1) { return brainfuck_run_return_t::INPUT_FAILURE; }
-				*data_ptr = input_result;
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+			result.error = link_loops(result);
+			return result;
+		}
+
+		/*
+		   Known cell values: we run the program abstractly and keep track of which cells we know the value of.
+		   At the start of the program, every cell is zero. After a loop, its cell is zero. After a "+++", the cell is whatever it was plus 3.
+		   That's enough to get rid of a surprising amount of work:
+		   	--> Loops (and multiply loops and scans) whose cell is known to be zero are dead and get removed completely.
+			Think comment loops at the start of the program and loops right after another loop ends.
+			--> Loops whose cell is known to be non-zero are peeled: the body gets emitted as straight-line code and we look at the cell again.
+			If that ends with the cell known to be zero, the loop had a known iteration count and turned into fixed-iteration code without any loop at all.
+			If we lose track of the cell (or run out of peeling budget, see max_peeled_instruction_count), the peeled code is thrown away again
+			and the loop stays a loop. A partially peeled loop would just be a bigger program, it wouldn't get any faster.
+			--> Clearing a cell with a known value ("[-]" or any multiply loop without targets) is just an ADD. ADDs and MOVEs right next to each other
+			are merged, which also gets rid of redundant stores like "+++[-]" or "[-]" on a cell that's already zero.
+		   Everything else keeps the knowledge that's still valid: a loop that keeps the pointer balanced only forgets the cells that it writes,
+		   everything else (unbalanced loops, scans) forgets everything except that the current cell is zero afterwards.
+		   NOTE: This assumes that the program starts on a fresh tape, which is what all the engines give it (see the reset functions).
+		*/
+
+		// NOTE: What we know about the cells around the pointer. Cells that aren't in the list are zero at the start of the program
+		// (everything is) and unknown once we've lost track of the pointer. The list is small, if it runs full we forget some things, which is always safe.
+		struct known_cells_t {
+			static constexpr size_t max_cell_count = 32;
+
+			ptrdiff_t offsets[max_cell_count] { };
+			uint8_t values[max_cell_count] { };
+			bool is_known[max_cell_count] { };
+			size_t cell_count = 0;
+			bool other_cells_are_zero = true;
+			// NOTE: offsets are relative to where the pointer was when we started tracking it, this is where it is now.
+			ptrdiff_t pointer = 0;
+
+			// NOTE: offset is relative to the pointer. Returns false if the value isn't known.
+			constexpr bool get(ptrdiff_t offset, uint8_t& value) const {
+				for (size_t i = 0; i < cell_count; i++) {
+					if (offsets[i] != pointer + offset) { continue; }
+					value = values[i];
+					return is_known[i];
+				}
+				value = 0;
+				return other_cells_are_zero;
 			}
-			
-			else if constexpr (*source_code_ptr == '.') {
-				if (!write_output_byte(*data_ptr)) { return brainfuck_run_return_t::OUTPUT_FAILURE; }
-				return inner_run<source_code_const_string, src_offset + 1, depth>();
+
+			constexpr void set(ptrdiff_t offset, bool known, uint8_t value) {
+				size_t index = 0;
+				for (; index < cell_count; index++) { if (offsets[index] == pointer + offset) { break; } }
+				if (index == max_cell_count) {
+					// NOTE: Dropping a cell from the list would make it zero, so the other cells have to become unknown first.
+					// Then the unknown cells in the list don't say anything anymore and we can throw them out.
+					other_cells_are_zero = false;
+					size_t kept_count = 0;
+					for (size_t i = 0; i < cell_count; i++) {
+						if (!is_known[i]) { continue; }
+						offsets[kept_count] = offsets[i];
+						values[kept_count] = values[i];
+						is_known[kept_count] = true;
+						kept_count++;
+					}
+					// NOTE: Still full of known cells, we lose the oldest one.
+					if (kept_count == max_cell_count) {
+						for (size_t i = 1; i < kept_count; i++) { offsets[i - 1] = offsets[i]; values[i - 1] = values[i]; }
+						kept_count--;
+					}
+					cell_count = kept_count;
+					index = cell_count;
+				}
+				if (index == cell_count) { cell_count++; }
+				offsets[index] = pointer + offset;
+				values[index] = value;
+				is_known[index] = known;
 			}
 
-			else if constexpr (*source_code_ptr == '\0') {
-				static_assert(depth == 0, "brainfuck compilation failed: '[' character did not posess a succeeding ']' character");
-				return brainfuck_run_return_t::SUCCESS;
+			constexpr void forget_everything() {
+				cell_count = 0;
+				other_cells_are_zero = false;
+				pointer = 0;
 			}
+		};
 
-			else { return inner_run<source_code_const_string, src_offset + 1, depth>(); }
+		struct known_value_propagation_t {
+			// NOTE: How many instructions' worth of loop bodies we're allowed to peel in the whole program.
+			static constexpr size_t max_peeled_instruction_count = 1024;
+			// NOTE: The pass recurses into loop bodies, anything nested deeper than this is copied as it is (the constexpr call depth is limited).
+			static constexpr size_t max_depth = 64;
+
+			instruction_buffer_t result;
+			size_t peel_budget = max_peeled_instruction_count;
+			size_t depth = 0;
+			// NOTE: Instructions before this index are never merged into, so a failed peel can be thrown away by just cutting the result off.
+			size_t merge_barrier = 0;
+		};
+
+		// NOTE: Emits the instruction, merging it into the previous one if they're both ADDs or both MOVEs.
+		// A MOVE only disappears if it doesn't go anywhere, since its range still has to be checked (and the tape grown).
+		constexpr bool emit_merged(known_value_propagation_t& propagation, const instruction_t& instruction) {
+			instruction_buffer_t& result = propagation.result;
+			if (result.length > propagation.merge_barrier) {
+				instruction_t& previous = result[result.length - 1];
+				if (instruction.op == op_t::ADD && previous.op == op_t::ADD) {
+					previous.value = (uint8_t)(previous.value + instruction.value);
+					if (previous.value == 0) { result.length--; }
+					return true;
+				}
+				if (instruction.op == op_t::MOVE && previous.op == op_t::MOVE) {
+					if (previous.value + instruction.min < previous.min) { previous.min = previous.value + instruction.min; }
+					if (previous.value + instruction.max > previous.max) { previous.max = previous.value + instruction.max; }
+					previous.value += instruction.value;
+					if (previous.min == 0 && previous.max == 0) { result.length--; }
+					return true;
+				}
+			}
+			if (instruction.op == op_t::ADD && instruction.value == 0) { return true; }
+			return result.push_back(instruction);
 		}
 
-		brainfuck_run_return_t run() noexcept {
-			if (!data.data) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
-			return inner_run<source_code_const_string_original, 0, 0>();
+		// NOTE: Whether the pointer is back where it started after every iteration of the loop and of every loop inside of it. Scans never are.
+		constexpr bool is_balanced_loop(const instruction_buffer_t& program, size_t loop_begin) {
+			ptrdiff_t loop_offsets[known_value_propagation_t::max_depth] { };
+			size_t depth = 0;
+			ptrdiff_t offset = 0;
+			for (size_t i = loop_begin; i <= program[loop_begin].jump; i++) {
+				switch (program[i].op) {
+				case op_t::MOVE: offset += program[i].value; break;
+				case op_t::SCAN_RIGHT: case op_t::SCAN_LEFT: return false;
+				case op_t::LOOP_BEGIN:
+					if (depth == known_value_propagation_t::max_depth) { return false; }
+					loop_offsets[depth++] = offset;
+					break;
+				case op_t::LOOP_END: if (loop_offsets[--depth] != offset) { return false; } break;
+				default: break;
+				}
+			}
+			return true;
 		}
 
-		bool reset_state_keep_vec_reserved() noexcept {
-			data.release_length_keep_reserve();
-			data.push_back(0);
-			data_ptr = data.data;
-			data_end_ptr = data_ptr + 1;
+		// NOTE: Forgets every cell that a balanced loop might write to (including its own).
+		constexpr void forget_loop_writes(const instruction_buffer_t& program, size_t loop_begin, known_cells_t& cells) {
+			cells.set(0, false, 0);
+			ptrdiff_t offset = 0;
+			for (size_t i = loop_begin + 1; i < program[loop_begin].jump; i++) {
+				const instruction_t& instruction = program[i];
+				if (instruction.op == op_t::MOVE) { offset += instruction.value; }
+				else if (instruction.op == op_t::ADD || instruction.op == op_t::INPUT || instruction.op == op_t::MULTIPLY_LOOP) { cells.set(offset, false, 0); }
+				else if (instruction.op == op_t::MULTIPLY_ADD) { cells.set(offset + instruction.offset, false, 0); }
+			}
 		}
 
-		bool reset_state_unreserve_vec() noexcept {
-			data.reset_everything();
-			data.push_back(0);
-			data_ptr = data.data;
-			data_end_ptr = data_ptr + 1;
+		constexpr void propagate_known_values(const instruction_buffer_t& program, size_t begin, size_t end, known_cells_t& cells, known_value_propagation_t& propagation) {
+			instruction_buffer_t& result = propagation.result;
+			for (size_t i = begin; i < end; i++) {
+				const instruction_t& instruction = program[i];
+				uint8_t value = 0;
+				bool is_known = cells.get(0, value);
+
+				switch (instruction.op) {
+				case op_t::ADD:
+					if (!emit_merged(propagation, instruction)) { return; }
+					cells.set(0, is_known, value + instruction.value);
+					break;
+
+				case op_t::MOVE:
+					if (!emit_merged(propagation, instruction)) { return; }
+					cells.pointer += instruction.value;
+					break;
+
+				case op_t::INPUT:
+					if (!result.push_back(instruction)) { return; }
+					cells.set(0, false, 0);
+					break;
+
+				case op_t::MULTIPLY_LOOP: {
+					size_t loop_begin = i;
+					i = instruction.jump - 1;
+					if (is_known && value == 0) { break; }
+					// NOTE: Without targets and without a range to check, a known loop is just an ADD.
+					if (is_known && instruction.jump == loop_begin + 1 && instruction.min == 0 && instruction.max == 0) {
+						if (!emit_merged(propagation, instruction_t { .op = op_t::ADD, .value = (uint8_t)-value, .src_offset = instruction.src_offset })) { return; }
+						cells.set(0, true, 0);
+						break;
+					}
+					if (!result.push_back(instruction)) { return; }
+					uint8_t iterations = helpers::multiply_loop_iterations(instruction.value, value);
+					for (size_t j = loop_begin + 1; j < instruction.jump; j++) {
+						if (!result.push_back(program[j])) { return; }
+						uint8_t target_value = 0;
+						bool is_target_known = is_known && cells.get(program[j].offset, target_value);
+						cells.set(program[j].offset, is_target_known, target_value + (uint8_t)(program[j].value * iterations));
+					}
+					cells.set(0, true, 0);
+					break;
+				}
+
+				case op_t::SCAN_RIGHT: case op_t::SCAN_LEFT:
+					if (is_known && value == 0) { break; }
+					if (!result.push_back(instruction)) { return; }
+					cells.forget_everything();
+					cells.set(0, true, 0);
+					break;
+
+				case op_t::LOOP_BEGIN: {
+					size_t loop_begin = i;
+					size_t loop_end = instruction.jump;
+					i = loop_end;
+					if (is_known && value == 0) { break; }
+
+					if (propagation.depth == known_value_propagation_t::max_depth) {
+						for (size_t j = loop_begin; j <= loop_end; j++) { if (!result.push_back(program[j])) { return; } }
+						cells.forget_everything();
+						cells.set(0, true, 0);
+						break;
+					}
+
+					propagation.depth++;
+					if (is_known) {
+						size_t peel_begin = result.length;
+						size_t merge_barrier = propagation.merge_barrier;
+						known_cells_t entry_cells = cells;
+						propagation.merge_barrier = peel_begin;
+						// NOTE: The budget isn't given back if the peeling fails, that way the total work is bounded no matter how the loops are nested.
+						while (is_known && value != 0 && propagation.peel_budget > loop_end - loop_begin) {
+							propagation.peel_budget -= loop_end - loop_begin;
+							propagate_known_values(program, loop_begin + 1, loop_end, cells, propagation);
+							if (result.error != parse_error_t::NONE) { return; }
+							is_known = cells.get(0, value);
+						}
+						propagation.merge_barrier = merge_barrier;
+						if (is_known && value == 0) { propagation.depth--; break; }
+						result.length = peel_begin;
+						cells = entry_cells;
+					}
+
+					if (is_balanced_loop(program, loop_begin)) { forget_loop_writes(program, loop_begin, cells); }
+					else { cells.forget_everything(); }
+					known_cells_t body_cells = cells;
+					body_cells.set(0, false, 0);
+					if (!result.push_back(program[loop_begin])) { return; }
+					propagate_known_values(program, loop_begin + 1, loop_end, body_cells, propagation);
+					if (result.error != parse_error_t::NONE || !result.push_back(program[loop_end])) { return; }
+					propagation.depth--;
+					cells.set(0, true, 0);
+					break;
+				}
+
+				default:
+					if (!result.push_back(instruction)) { return; }
+					break;
+				}
+			}
 		}
-	};
 
-// NOTE: The callbacks can be any functor, including function pointers,
-// but you probably shouldn't use function pointers, since
-// calls to other functors are easier to optimize out for the compiler.
-// If you do use function pointers, at least have the
-// target functions reside in the same translation unit as the
-// compiled brainfuck program. That way, the compiler
-// should have a much easier time inlining the function calls.
-#define META_COMPILE_BRAINFUCK_WITH_CUSTOM_BUCKET_INC_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, bucket_inc_size) []() { \
-auto read_input_byte_callback_temp = read_input_byte_callback; \
-auto write_output_byte_callback_temp = write_output_byte_callback; \
-static constexpr const char *source_code_ptr = source_code; \
-return meta::compiled_brainfuck_t<source_code_ptr, decltype(read_input_byte_callback_temp), decltype(write_output_byte_callback_temp), bucket_inc_size>(read_input_byte_callback_temp, write_output_byte_callback_temp); \
-}()
-//return meta::compiled_brainfuck_t<source_code_const_string>();	// This is something we had in a previous revision, seems weird but works.
-// Explanation: because it can't be a type in this context, the compiler is smart enought to pick up on the meaning.
-// For template args it's different because first an argument list is constructed and then that list is compared with every found template
-// definition of the function and a set of valid overloads is constructed. These are then further narrowed down by comparing the function
-// argument lists.
-// The bottom line is that the compiler doesn't know what type of argument it's shooting for before constructing the initial list, so it
-// always assumes type instead of non-type when it can, because that makes the most sense.
+		// NOTE: If the tape doesn't start out zeroed, we don't know anything about any cell until the program writes to it.
+		constexpr instruction_buffer_t propagate_known_values(const instruction_buffer_t& program, bool is_tape_zeroed) {
+			known_value_propagation_t propagation;
+			known_cells_t cells;
+			if (!is_tape_zeroed) { cells.forget_everything(); }
+			if (!propagation.result.reserve(program.length)) { return std::move(propagation.result); }
+			propagate_known_values(program, 0, program.length, cells, propagation);
+			if (propagation.result.error != parse_error_t::NONE) { return std::move(propagation.result); }
+			propagation.result.error = link_loops(propagation.result);
+			return std::move(propagation.result);
+		}
 
-#define META_COMPILE_BRAINFUCK(source_code, read_input_byte_callback, write_output_byte_callback) META_COMPILE_BRAINFUCK_WITH_CUSTOM_BUCKET_INC_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT)
+		constexpr bool is_checkpoint(op_t op) {
+			switch (op) {
+			case op_t::LOOP_BEGIN: case op_t::LOOP_END: case op_t::MULTIPLY_LOOP: case op_t::INPUT: case op_t::OUTPUT: 
+			case op_t::SCAN_RIGHT: case op_t::SCAN_LEFT: case op_t::END: return true;
+			default: return false;
+			}
+		}
+
+		/*
+		   Tapes that don't check every pointer move (see helpers::reserved_vector) only check the pointer at checkpoints:
+		   loop entries, loop back-edges, multiply loops, I/O, scans and the end of the program.
+		   Multiply loops are checkpoints because they only touch their targets if the origin isn't 0, so their range has to be
+		   checked separately (after the checkpoint, when we know the loop actually runs).
+		   Between two checkpoints there's only straight-line code (control flow only ever merges at checkpoints), so we know at
+		   compile-time which cells the code in between touched, relative to where the pointer is at the checkpoint.
+		   That range gets stored in the checked_min and checked_max of the checkpoint instruction, which means a single check at the checkpoint
+		   catches everything that the unchecked moves before it did.
+		*/
+		constexpr void annotate_checkpoint_ranges(instruction_buffer_t& program) {
+			ptrdiff_t offset = 0;
+			ptrdiff_t min = 0;
+			ptrdiff_t max = 0;
+			for (size_t i = 0; i < program.length; i++) {
+				const instruction_t& instruction = program[i];
+				if (instruction.op == op_t::MOVE) {
+					if (offset + instruction.min < min) { min = offset + instruction.min; }
+					if (offset + instruction.max > max) { max = offset + instruction.max; }
+					offset += instruction.value;
+				}
+				else if (is_checkpoint(instruction.op)) {
+					program[i].checked_min = min - offset;
+					program[i].checked_max = max - offset;
+					offset = 0;
+					min = 0;
+					max = 0;
+				}
+			}
+		}
+
+		/*
+		   A loop is balanced if the pointer is back at the loop's cell after every iteration, and the same goes for every loop inside of it.
+		   That means we know at compile-time which cells the whole loop (nested loops included) can touch, relative to the loop's cell.
+		   The engines can then check (and grow) that whole range once when they enter the loop, and run the body without any checks at all.
+		   Scans make a loop unbalanced, since they move the pointer by an unknown amount.
+		   NOTE: The range includes everything that might run, not what will run. A nested loop that never actually runs still counts,
+		   so the engines have to fall back to the checked version of the loop if the range check fails.
+		*/
+		constexpr void annotate_balanced_loops(instruction_buffer_t& program) {
+			// NOTE: Loops nested deeper than this make all the loops around them unbalanced. That's always safe, it's just slower.
+			constexpr size_t max_depth = 64;
+			struct open_loop_t {
+				size_t begin;
+				ptrdiff_t entry_offset;
+				ptrdiff_t min;
+				ptrdiff_t max;
+				bool is_balanced;
+			};
+			open_loop_t open_loops[max_depth] { };
+			size_t depth = 0;
+			size_t untracked_depth = 0;
+			ptrdiff_t offset = 0;
+
+			for (size_t i = 0; i < program.length; i++) {
+				const instruction_t& instruction = program[i];
+				open_loop_t* loop = depth != 0 && untracked_depth == 0 ? &open_loops[depth - 1] : nullptr;
+				switch (instruction.op) {
+				case op_t::MOVE: case op_t::MULTIPLY_LOOP:
+					if (loop) {
+						if (offset + instruction.min < loop->min) { loop->min = offset + instruction.min; }
+						if (offset + instruction.max > loop->max) { loop->max = offset + instruction.max; }
+					}
+					if (instruction.op == op_t::MOVE) { offset += instruction.value; }
+					break;
+				case op_t::SCAN_RIGHT: case op_t::SCAN_LEFT: if (loop) { loop->is_balanced = false; } break;
+				case op_t::LOOP_BEGIN:
+					if (untracked_depth != 0 || depth == max_depth) {
+						if (loop) { loop->is_balanced = false; }
+						untracked_depth++;
+						break;
+					}
+					open_loops[depth++] = open_loop_t { i, offset, offset, offset, true };
+					break;
+				case op_t::LOOP_END: {
+					if (untracked_depth != 0) { untracked_depth--; break; }
+					open_loop_t closed_loop = open_loops[--depth];
+					if (!closed_loop.is_balanced || offset != closed_loop.entry_offset) {
+						// NOTE: The offset doesn't mean anything after an unbalanced loop, but everything around it is unbalanced now anyway.
+						if (depth != 0) { open_loops[depth - 1].is_balanced = false; }
+						break;
+					}
+					program[closed_loop.begin].value = 1;
+					program[closed_loop.begin].min = closed_loop.min - closed_loop.entry_offset;
+					program[closed_loop.begin].max = closed_loop.max - closed_loop.entry_offset;
+					if (depth != 0) {
+						open_loop_t& parent = open_loops[depth - 1];
+						if (closed_loop.min < parent.min) { parent.min = closed_loop.min; }
+						if (closed_loop.max > parent.max) { parent.max = closed_loop.max; }
+					}
+					break;
+				}
+				default: break;
+				}
+			}
+		}
+
+		// NOTE: The widest range that the pointer can move through without being checked.
+		// This is how much slack an unchecked tape needs on either side.
+		// Multiply loops and balanced loops check their whole range from a pointer that is on the tape, so their ranges count too.
+		template <size_t length>
+		constexpr size_t max_checkpoint_range(const instruction_t (&instructions)[length]) {
+			size_t result = 0;
+			for (size_t i = 0; i < length; i++) {
+				if (!is_checkpoint(instructions[i].op)) { continue; }
+				if ((size_t)(instructions[i].checked_max - instructions[i].checked_min) > result) { result = instructions[i].checked_max - instructions[i].checked_min; }
+				bool is_range_checked = instructions[i].op == op_t::MULTIPLY_LOOP || (instructions[i].op == op_t::LOOP_BEGIN && instructions[i].value == 1);
+				if (is_range_checked && (size_t)(instructions[i].max - instructions[i].min) > result) { result = instructions[i].max - instructions[i].min; }
+			}
+			return result;
+		}
+
+		// NOTE: This is the whole pipeline. It's used for the compile-time compiler, but it's constexpr and not consteval,
+		// so it works just as well for sources that are only known at runtime.
+		constexpr instruction_buffer_t compile(std::string_view source, bool is_tape_zeroed = true) {
+			instruction_buffer_t program = parse(source);
+			if (program.error != parse_error_t::NONE) { return program; }
+			program = recognize_loop_idioms(program);
+			if (program.error != parse_error_t::NONE) { return program; }
+			program = propagate_known_values(program, is_tape_zeroed);
+			if (program.error != parse_error_t::NONE) { return program; }
+			annotate_checkpoint_ranges(program);
+			annotate_balanced_loops(program);
+			return program;
+		}
+
+		/*
+		   Fixed-size version of the IR, so that it can be stored in a static constexpr variable.
+		   We don't know the size before compiling, so compile-time users compile twice: once to get the length
+		   (the transient allocation gets thrown away) and once to fill this thing.
+		*/
+		template <size_t length>
+		struct program_t {
+			instruction_t instructions[length];
+			parse_error_t error = parse_error_t::NONE;
+
+			// NOTE: The index of the next instruction in the same block, skipping over the contents of loops.
+			constexpr size_t next_statement(size_t index) const {
+				if (instructions[index].op == op_t::LOOP_BEGIN) { return instructions[index].jump + 1; }
+				if (instructions[index].op == op_t::MULTIPLY_LOOP) { return instructions[index].jump; }
+				return index + 1;
+			}
+
+			// NOTE: A block is the top level of the program or the body of a loop. It ends at the END or the LOOP_END.
+			constexpr size_t block_length(size_t block_begin) const {
+				size_t result = 0;
+				for (size_t i = block_begin; instructions[i].op != op_t::END && instructions[i].op != op_t::LOOP_END; i = next_statement(i)) { result++; }
+				return result;
+			}
+
+			// NOTE: How many statements of the block come before the given one. For the END or LOOP_END of the block, that's block_length.
+			constexpr size_t statement_position(size_t block_begin, size_t index) const {
+				size_t result = 0;
+				for (size_t i = block_begin; i != index; i = next_statement(i)) { result++; }
+				return result;
+			}
+		};
+
+		template <size_t length>
+		struct statement_list_t {
+			size_t indices[length == 0 ? 1 : length] { };
+		};
+
+		template <size_t length>
+		constexpr program_t<length> make_program(std::string_view source, bool is_tape_zeroed = true) {
+			program_t<length> result;
+			instruction_buffer_t program = compile(source, is_tape_zeroed);
+			result.error = program.error;
+			if (program.error != parse_error_t::NONE) { return result; }
+			for (size_t i = 0; i < length; i++) { result.instructions[i] = program[i]; }
+			return result;
+		}
+
+		constexpr size_t program_length(std::string_view source, bool is_tape_zeroed = true) {
+			instruction_buffer_t program = compile(source, is_tape_zeroed);
+			// NOTE: Still has to be at least 1 on failure so that program_t has something to hold.
+			return program.error != parse_error_t::NONE ? 1 : program.length;
+		}
+
+		template <size_t block_length, size_t program_length>
+		constexpr statement_list_t<block_length> make_statement_list(const program_t<program_length>& program, size_t block_begin) {
+			statement_list_t<block_length> result;
+			size_t statement = block_begin;
+			for (size_t i = 0; i < block_length; i++) {
+				result.indices[i] = statement;
+				statement = program.next_statement(statement);
+			}
+			return result;
+		}
+
+		// NOTE: Where the pointer is (relative to where it was at the start of the block) when each statement of the block runs.
+		// Only meaningful for the bodies of balanced loops, where nested loops don't move the pointer.
+		template <size_t length>
+		struct statement_offset_list_t {
+			ptrdiff_t offsets[length == 0 ? 1 : length] { };
+		};
+
+		template <size_t block_length, size_t program_length>
+		constexpr statement_offset_list_t<block_length> make_statement_offset_list(const program_t<program_length>& program, size_t block_begin) {
+			statement_offset_list_t<block_length> result;
+			ptrdiff_t offset = 0;
+			size_t statement = block_begin;
+			for (size_t i = 0; i < block_length; i++) {
+				result.offsets[i] = offset;
+				if (program.instructions[statement].op == op_t::MOVE) { offset += program.instructions[statement].value; }
+				statement = program.next_statement(statement);
+			}
+			return result;
+		}
+
+		// NOTE: For every instruction, the index of the LOOP_BEGIN of the loop it's in (length if it's not in a loop).
+		// A LOOP_END belongs to the loop around its loop, just like its LOOP_BEGIN.
+		template <size_t length>
+		struct enclosing_loop_list_t {
+			size_t indices[length];
+		};
+
+		template <size_t length>
+		constexpr enclosing_loop_list_t<length> make_enclosing_loop_list(const program_t<length>& program) {
+			enclosing_loop_list_t<length> result { };
+			size_t current_loop = length;
+			for (size_t i = 0; i < length; i++) {
+				if (program.instructions[i].op == op_t::LOOP_END) { current_loop = result.indices[program.instructions[i].jump]; }
+				result.indices[i] = current_loop;
+				if (program.instructions[i].op == op_t::LOOP_BEGIN) { current_loop = i; }
+			}
+			return result;
+		}
+
+		/*
+		   Compile-time partial evaluation: a lot of programs spend their first couple million steps calculating constants or printing
+		   banners before they ever read anything. None of that depends on the input, so we can just as well do it while compiling.
+		   evaluate_prefix runs the program in a constexpr interpreter until one of these comes up:
+		   	--> an INPUT or the END of the program
+			--> step_budget executed instructions (every IR instruction is one step, no matter how much work it does)
+			--> an instruction that would fail (pointer below cell 0, more than max_tape_length cells), which is left for the runtime
+			to run and report, so the error shows up at the same point as without the evaluation
+		   The result is the tape, the pointer, everything that was output so far and the index of the instruction that the runtime
+		   has to resume at. That can be any instruction except a MULTIPLY_ADD (they're part of their multiply loop), including a LOOP_END,
+		   which means the body is done and the loop condition has to be checked next.
+		   NOTE: The tape grows exactly like a helpers::non_bad_vector would, so that the tape length is the same as without the evaluation.
+		*/
+
+		// NOTE: Growable byte array for the evaluation. It only ever lives inside of constant evaluation, so it's new and delete only.
+		class byte_buffer_t {
+		public:
+			uint8_t* data = nullptr;
+			size_t length = 0;
+			size_t capacity = 0;
+
+			constexpr byte_buffer_t() = default;
+
+			byte_buffer_t(const byte_buffer_t& other) = delete;
+
+			// NOTE: New elements are zero.
+			constexpr void resize(size_t new_length) {
+				if (new_length > capacity) {
+					size_t new_capacity = capacity == 0 ? 64 : capacity;
+					while (new_capacity < new_length) { new_capacity *= 2; }
+					uint8_t* new_data = new uint8_t[new_capacity] { };
+					for (size_t i = 0; i < length; i++) { new_data[i] = data[i]; }
+					delete[] data;
+					data = new_data;
+					capacity = new_capacity;
+				}
+				for (size_t i = length; i < new_length; i++) { data[i] = 0; }
+				length = new_length;
+			}
+
+			constexpr void push_back(uint8_t element) {
+				resize(length + 1);
+				data[length - 1] = element;
+			}
+
+			constexpr ~byte_buffer_t() { delete[] data; }
+		};
+
+		struct prefix_evaluation_t {
+			byte_buffer_t tape;
+			byte_buffer_t output;
+			size_t data_ptr_index = 0;
+			size_t resume_index = 0;
+			size_t step_count = 0;
+		};
+
+		// NOTE: Makes sure that [data_ptr_index + min, data_ptr_index + max] is on the tape, like a checked move would. Returns false if that would fail.
+		constexpr bool reserve_prefix_range(prefix_evaluation_t& evaluation, ptrdiff_t min, ptrdiff_t max, size_t max_tape_length) {
+			if ((ptrdiff_t)evaluation.data_ptr_index < -min) { return false; }
+			if (evaluation.data_ptr_index + max >= max_tape_length) { return false; }
+			if (evaluation.data_ptr_index + max >= evaluation.tape.length) { evaluation.tape.resize(evaluation.data_ptr_index + max + 1); }
+			return true;
+		}
+
+		// NOTE: Runs the instruction and returns the index of the next one, or (size_t)-1 if the evaluation has to stop before this instruction.
+		template <size_t length>
+		constexpr size_t evaluate_prefix_instruction(const program_t<length>& program, size_t index, prefix_evaluation_t& evaluation, size_t max_tape_length) {
+			const instruction_t& instruction = program.instructions[index];
+			uint8_t& cell = evaluation.tape.data[evaluation.data_ptr_index];
+			switch (instruction.op) {
+			case op_t::ADD: cell += (uint8_t)instruction.value; return index + 1;
+			case op_t::MOVE:
+				if (!reserve_prefix_range(evaluation, instruction.min, instruction.max, max_tape_length)) { return (size_t)-1; }
+				evaluation.data_ptr_index += instruction.value;
+				return index + 1;
+			case op_t::OUTPUT: evaluation.output.push_back(cell); return index + 1;
+			case op_t::LOOP_BEGIN: return cell == 0 ? instruction.jump + 1 : index + 1;
+			case op_t::LOOP_END: return cell != 0 ? instruction.jump + 1 : index + 1;
+			case op_t::MULTIPLY_LOOP: {
+				if (cell == 0) { return instruction.jump; }
+				if (!reserve_prefix_range(evaluation, instruction.min, instruction.max, max_tape_length)) { return (size_t)-1; }
+				// NOTE: The tape might have been reallocated, so cell isn't valid anymore.
+				uint8_t* origin = evaluation.tape.data + evaluation.data_ptr_index;
+				uint8_t iterations = helpers::multiply_loop_iterations(instruction.value, *origin);
+				for (size_t i = index + 1; i < instruction.jump; i++) { origin[program.instructions[i].offset] += (uint8_t)(program.instructions[i].value * iterations); }
+				*origin = 0;
+				return instruction.jump;
+			}
+			case op_t::SCAN_RIGHT:
+				if (cell == 0) { return index + 1; }
+				while (evaluation.data_ptr_index < evaluation.tape.length && evaluation.tape.data[evaluation.data_ptr_index] != 0) { evaluation.data_ptr_index++; }
+				if (evaluation.data_ptr_index == evaluation.tape.length) {
+					if (evaluation.tape.length == max_tape_length) { return (size_t)-1; }
+					evaluation.tape.resize(evaluation.tape.length + 1);
+				}
+				return index + 1;
+			case op_t::SCAN_LEFT: {
+				if (cell == 0) { return index + 1; }
+				size_t zero_index = evaluation.data_ptr_index;
+				while (zero_index != 0 && evaluation.tape.data[zero_index] != 0) { zero_index--; }
+				if (evaluation.tape.data[zero_index] != 0) { return (size_t)-1; }
+				evaluation.data_ptr_index = zero_index;
+				return index + 1;
+			}
+			default: return (size_t)-1;
+			}
+		}
+
+		template <size_t length>
+		constexpr void evaluate_prefix(const program_t<length>& program, size_t step_budget, size_t max_tape_length, prefix_evaluation_t& evaluation) {
+			evaluation.tape.resize(1);
+			// NOTE: A broken program doesn't have any instructions to run, it only gets this far so that the static_asserts can fire.
+			if (program.error != parse_error_t::NONE) { return; }
+			size_t index = 0;
+			for (; evaluation.step_count < step_budget; evaluation.step_count++) {
+				size_t next_index = evaluate_prefix_instruction(program, index, evaluation, max_tape_length);
+				if (next_index == (size_t)-1) { break; }
+				index = next_index;
+			}
+			evaluation.resume_index = index;
+		}
+
+		// NOTE: Same two-step dance as with program_t: first we only get the sizes, then we evaluate again to fill the fixed-size arrays.
+		struct prefix_info_t {
+			size_t tape_length;
+			size_t output_length;
+			size_t step_count;
+		};
+
+		template <size_t tape_length, size_t output_length>
+		struct prefix_t {
+			uint8_t tape[tape_length];
+			uint8_t output[output_length == 0 ? 1 : output_length];
+			size_t data_ptr_index;
+			size_t resume_index;
+		};
+
+		template <size_t length>
+		constexpr prefix_info_t make_prefix_info(const program_t<length>& program, size_t step_budget, size_t max_tape_length) {
+			prefix_evaluation_t evaluation;
+			evaluate_prefix(program, step_budget, max_tape_length, evaluation);
+			return prefix_info_t { evaluation.tape.length, evaluation.output.length, evaluation.step_count };
+		}
+
+		template <size_t tape_length, size_t output_length, size_t length>
+		constexpr prefix_t<tape_length, output_length> make_prefix(const program_t<length>& program, size_t step_budget, size_t max_tape_length) {
+			prefix_t<tape_length, output_length> result { };
+			prefix_evaluation_t evaluation;
+			evaluate_prefix(program, step_budget, max_tape_length, evaluation);
+			for (size_t i = 0; i < tape_length; i++) { result.tape[i] = evaluation.tape.data[i]; }
+			for (size_t i = 0; i < output_length; i++) { result.output[i] = evaluation.output.data[i]; }
+			result.data_ptr_index = evaluation.data_ptr_index;
+			result.resume_index = evaluation.resume_index;
+			return result;
+		}
+
+	}
+
+	enum class brainfuck_run_return_t : uint8_t {
+		ALLOCATION_FAILURE,
+		SUCCESS,
+		INPUT_FAILURE,
+		OUTPUT_FAILURE,
+		// NOTE: Only ever returned by resumable programs (execution_t::RESUMABLE), see compiled_brainfuck_t::resume().
+		NEEDS_INPUT,
+		NEEDS_OUTPUT_DRAIN
+	};
+
+	template <typename A_t, typename B_t>
+	struct are_types_same { consteval operator bool() const { return false; } };
+
+	template <typename A_t>
+	struct are_types_same<A_t, A_t> { consteval operator bool() const { return true; } };
+
+	template <typename T, typename conduit_t>
+	struct is_invokable_through { };
+
+	template <typename T, typename conduit_ret_t, typename... conduit_param_types>
+	struct is_invokable_through<T, conduit_ret_t(conduit_param_types...)> {
+	private:
+		using yes_ret_t = char[2];
+		using no_ret_t = char[1];
+
+		template <typename U, typename ret_t, typename... param_types, 
+			 typename std::enable_if<are_types_same<decltype((*(U*)nullptr)((*(param_types*)nullptr)...)), ret_t> { }, bool>::type = true>
+		consteval yes_ret_t& filter(void*) const;
+
+		// NOTE: Apparently only funcs with templated definitions are considered in overload resolution, so we have to put this here.
+		template <typename U, typename ret_t, typename... param_types>
+		consteval no_ret_t& filter(...) const;
+
+	public:
+		consteval operator bool() const { return sizeof(filter<T, conduit_ret_t, conduit_param_types...>(nullptr)) == sizeof(yes_ret_t); }
+	};
+
+	enum class tape_backend_t : uint8_t {
+		// NOTE: helpers::non_bad_vector, every pointer move is checked and the vector grows as needed.
+		HEAP_VECTOR,
+		// NOTE: helpers::reserved_vector, pointer moves are unchecked and the pointer only gets checked at checkpoints.
+		RESERVED_VIRTUAL_MEMORY
+	};
+
+	enum class execution_t : uint8_t {
+		// NOTE: ',' and '.' wait for the functors to finish, run() only returns once the program is done (or failed).
+		BLOCKING,
+		// NOTE: The functors can say that they can't do anything right now, run() then returns NEEDS_INPUT or NEEDS_OUTPUT_DRAIN
+		// and resume() picks up exactly where the program stopped. See compiled_brainfuck_t::resume().
+		RESUMABLE
+	};
+
+	enum class initial_tape_t : uint8_t {
+		// NOTE: The program always starts on a tape full of zeros, which is what lets ir::propagate_known_values do its thing.
+		ZEROED,
+		// NOTE: The program can start on a tape that already has something in it (see the tape constructor of compiled_brainfuck_t).
+		// Known value propagation then only knows about the cells that the program wrote itself. Doesn't work with a prefix_step_budget.
+		ARBITRARY
+	};
+
+	enum class instrumentation_t : uint8_t {
+		// NOTE: No instrumentation at all, the generated code is exactly the same as if this option didn't exist.
+		NONE,
+		// NOTE: Counts how often every instruction runs and how many iterations every loop does, see helpers::profile_t.
+		PROFILING
+	};
+
+	namespace helpers {
+
+		/*
+		   The counters of a profiling compiled_brainfuck_t. They're indexed by the instruction index, which is known at compile-time,
+		   so counting is a single increment of a fixed address (no lookups). Every instruction knows its src_offset, that's how we get back to the source.
+		   We only count loop iterations (and runs), not every single instruction. Everything in a loop body runs exactly once per iteration,
+		   so the execution count of any instruction is just the iteration count of the loop around it (see compiled_brainfuck_t::profiled_execution_count).
+		   That keeps the overhead at one increment per loop iteration, which is next to nothing compared to the body.
+		   NOTE: This lives inside of the compiled_brainfuck_t, so it's 8 bytes per instruction of extra object size. Keep that in mind
+		   if you put the instance on the stack with big programs.
+		*/
+		template <size_t program_length>
+		struct profile_t {
+			// NOTE: Only used for loops (LOOP_BEGIN, MULTIPLY_LOOP, SCAN_*): how often the body ran in total.
+			// Multiply loops and scans don't actually loop anymore, but we count the iterations the original loop would have done.
+			uint64_t loop_iterations[program_length] { };
+			uint64_t run_count = 0;
+			size_t max_tape_length = 0;
+		};
+
+	}
+
+	/*
+	   What an output functor can return instead of a bool. FAILURE and SUCCESS are the same as false and true (so a bool converts to this directly),
+	   WOULD_BLOCK means the output couldn't be taken right now (full socket buffer, etc.) and that the functor wants to be called again with
+	   exactly the same output later. Only resumable programs do that, everything else treats WOULD_BLOCK as a failure.
+	*/
+	enum class output_status_t : uint8_t {
+		FAILURE,
+		SUCCESS,
+		WOULD_BLOCK
+	};
+
+	// NOTE: The same thing for input functors: the per-byte version returns input_byte_would_block and the batched version
+	// returns input_length_would_block if there isn't any input yet. Programs that aren't resumable don't treat these values specially.
+	inline constexpr uint16_t input_byte_would_block = (uint16_t)-2;
+	inline constexpr size_t input_length_would_block = (size_t)-1;
+
+	/*
+	   The functors can either work byte by byte or in batches:
+	   	--> uint16_t() and bool(uint8_t) are the per-byte versions, which get called for every ',' and '.'.
+		--> size_t(uint8_t*, size_t) and bool(const uint8_t*, size_t) are the batched versions.
+		The input functor gets a buffer and its size and fills (part of) it, returning how many bytes it wrote. Returning 0 is an input failure.
+		The output functor gets a chunk of output and returns whether it succeeded.
+		Output functors can return an output_status_t instead of a bool (with both versions).
+		With the batched versions, the compiled program reads from and writes to internal buffers (io_buffer_size bytes each)
+		and only calls the functors when those run empty or full, which gets rid of the per-byte call overhead.
+	   Any mix of the two is allowed. If a functor is callable through both signatures, the per-byte version wins.
+	*/
+	template <typename input_functor_t>
+	inline constexpr bool has_per_byte_input = is_invokable_through<input_functor_t, uint16_t()> { };
+
+	template <typename input_functor_t>
+	inline constexpr bool has_batched_input = !has_per_byte_input<input_functor_t> && is_invokable_through<input_functor_t, size_t(uint8_t*, size_t)> { };
+
+	template <typename output_functor_t>
+	inline constexpr bool has_per_byte_output = is_invokable_through<output_functor_t, bool(uint8_t)> { } || 
+		is_invokable_through<output_functor_t, output_status_t(uint8_t)> { };
+
+	template <typename output_functor_t>
+	inline constexpr bool has_batched_output = !has_per_byte_output<output_functor_t> && 
+		(is_invokable_through<output_functor_t, bool(const uint8_t*, size_t)> { } || is_invokable_through<output_functor_t, output_status_t(const uint8_t*, size_t)> { });
+
+	namespace helpers {
+
+		// NOTE: The functors and the I/O buffers, shared by all the engines so that they all behave exactly the same when it comes to I/O.
+		// If is_resumable, the "would block" values of the functors turn into NEEDS_INPUT and NEEDS_OUTPUT_DRAIN, and the operation
+		// that returned them can simply be done again later (nothing was consumed or lost).
+		template <typename input_functor_t, typename output_functor_t, size_t io_buffer_size, bool is_resumable = false>
+		class brainfuck_io_t {
+		public:
+			using read_input_byte_t = input_functor_t;
+			using write_output_byte_t = output_functor_t;
+
+			input_functor_t read_input_byte;
+			output_functor_t write_output_byte;
+
+			[[no_unique_address]] std::conditional_t<has_batched_input<input_functor_t>, io_buffer_t<io_buffer_size>, empty_t> input_buffer;
+			[[no_unique_address]] std::conditional_t<has_batched_output<output_functor_t>, io_buffer_t<io_buffer_size>, empty_t> output_buffer;
+
+			constexpr brainfuck_io_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback) : 
+				read_input_byte(read_input_byte_callback), write_output_byte(write_output_byte_callback)
+			{ }
+
+			static brainfuck_run_return_t output_return_value(output_status_t status) noexcept {
+				if (status == output_status_t::SUCCESS) { return brainfuck_run_return_t::SUCCESS; }
+				if (is_resumable && status == output_status_t::WOULD_BLOCK) { return brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN; }
+				return brainfuck_run_return_t::OUTPUT_FAILURE;
+			}
+
+			// NOTE: Hands everything that's in the output buffer to the output functor. Does nothing with per-byte output.
+			// If the functor can't take it right now (NEEDS_OUTPUT_DRAIN), it stays in the buffer for the next try.
+			brainfuck_run_return_t write_buffered_output() noexcept {
+				if constexpr (has_batched_output<output_functor_t>) {
+					if (output_buffer.length == 0) { return brainfuck_run_return_t::SUCCESS; }
+					brainfuck_run_return_t return_value = output_return_value((output_status_t)write_output_byte((const uint8_t*)output_buffer.data, output_buffer.length));
+					if (return_value != brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN) { output_buffer.length = 0; }
+					return return_value;
+				}
+				return brainfuck_run_return_t::SUCCESS;
+			}
+
+			// NOTE: Same thing, but the buffer is always empty afterwards, for the final flush of a program that's not going to continue.
+			bool flush_output() noexcept {
+				brainfuck_run_return_t return_value = write_buffered_output();
+				if constexpr (has_batched_output<output_functor_t>) { output_buffer.length = 0; }
+				return return_value == brainfuck_run_return_t::SUCCESS;
+			}
+
+			brainfuck_run_return_t input_to_cell(uint8_t* cell) noexcept {
+				if constexpr (has_batched_input<input_functor_t>) {
+					if (input_buffer.position == input_buffer.length) {
+						// NOTE: The program might be waiting for this input because of something it just printed, so we flush before asking for more.
+						// As long as there's buffered input left, nothing can block, so the output keeps collecting in its buffer.
+						brainfuck_run_return_t flush_return_value = write_buffered_output();
+						if (flush_return_value != brainfuck_run_return_t::SUCCESS) { return flush_return_value; }
+						size_t length = read_input_byte((uint8_t*)input_buffer.data, io_buffer_size);
+						if constexpr (is_resumable) { if (length == input_length_would_block) { return brainfuck_run_return_t::NEEDS_INPUT; } }
+						if (length == 0 || length > io_buffer_size) { return brainfuck_run_return_t::INPUT_FAILURE; }
+						input_buffer.position = 0;
+						input_buffer.length = length;
+					}
+					*cell = input_buffer.data[input_buffer.position++];
+				}
+				else {
+					// NOTE: Same as above, except that every byte is a call to the functor that might block.
+					brainfuck_run_return_t flush_return_value = write_buffered_output();
+					if (flush_return_value != brainfuck_run_return_t::SUCCESS) { return flush_return_value; }
+					uint16_t input_result = read_input_byte();
+					if constexpr (is_resumable) { if (input_result == input_byte_would_block) { return brainfuck_run_return_t::NEEDS_INPUT; } }
+					if (input_result == (uint16_t)-1) { return brainfuck_run_return_t::INPUT_FAILURE; }
+					*cell = input_result;
+				}
+				return brainfuck_run_return_t::SUCCESS;
+			}
+
+			brainfuck_run_return_t output_from_cell(uint8_t value) noexcept {
+				if constexpr (has_batched_output<output_functor_t>) {
+					if (output_buffer.length == io_buffer_size) {
+						brainfuck_run_return_t return_value = write_buffered_output();
+						if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+					}
+					output_buffer.data[output_buffer.length++] = value;
+					return brainfuck_run_return_t::SUCCESS;
+				}
+				else { return output_return_value((output_status_t)write_output_byte(value)); }
+			}
+
+			// NOTE: With batched output, big chunks go straight to the functor in one call instead of through the buffer.
+			brainfuck_run_return_t output_bytes(const uint8_t* bytes, size_t length) noexcept {
+				if constexpr (has_batched_output<output_functor_t>) {
+					if (!flush_output() || (output_status_t)write_output_byte(bytes, length) != output_status_t::SUCCESS) { return brainfuck_run_return_t::OUTPUT_FAILURE; }
+				}
+				else {
+					for (size_t i = 0; i < length; i++) { if ((output_status_t)write_output_byte(bytes[i]) != output_status_t::SUCCESS) { return brainfuck_run_return_t::OUTPUT_FAILURE; } }
+				}
+				return brainfuck_run_return_t::SUCCESS;
+			}
+		};
+
+	}
+
+	template <const char * const& source_code_const_string_original, typename input_functor_t, typename output_functor_t, size_t data_vector_bucket_size, 
+		 tape_backend_t tape_backend = tape_backend_t::HEAP_VECTOR, size_t reserved_tape_size = META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT,
+		 size_t io_buffer_size = META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT, instrumentation_t instrumentation = instrumentation_t::NONE,
+		 size_t prefix_step_budget = 0, execution_t execution = execution_t::BLOCKING, initial_tape_t initial_tape = initial_tape_t::ZEROED,
+		 // NOTE: Doesn't care if the functions are noexcept or not, which is fine since that doesn't matter for us in this case.
+		 // NOTE: Also doesn't give any thought to whether they're const or anything, which is also fine since that doesn't concern us.
+		 typename std::enable_if<(has_per_byte_input<input_functor_t> || has_batched_input<input_functor_t>) &&
+			 (has_per_byte_output<output_functor_t> || has_batched_output<output_functor_t>), bool>::type = true>
+	class compiled_brainfuck_t : public helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size, execution == execution_t::RESUMABLE> {
+	public:
+		using io_t = helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size, execution == execution_t::RESUMABLE>;
+
+		// NOTE: See the ir namespace for how the program is represented. program_length has to be computed separately
+		// since we need it as a template argument.
+		static constexpr bool is_tape_zeroed = initial_tape == initial_tape_t::ZEROED;
+
+		static constexpr size_t program_length = ir::program_length(source_code_const_string_original, is_tape_zeroed);
+		static constexpr ir::program_t<program_length> program = ir::make_program<program_length>(source_code_const_string_original, is_tape_zeroed);
+
+		static_assert(program.error != ir::parse_error_t::UNMATCHED_LOOP_END, "brainfuck compilation failed: ']' character did not posess a preceding '[' character");
+		static_assert(program.error != ir::parse_error_t::UNMATCHED_LOOP_BEGIN, "brainfuck compilation failed: '[' character did not posess a succeeding ']' character");
+
+		static constexpr bool has_unchecked_tape = tape_backend == tape_backend_t::RESERVED_VIRTUAL_MEMORY;
+
+#ifndef META_BRAINFUCK_COMPILER_HAS_RESERVED_TAPE
+		static_assert(!has_unchecked_tape, "brainfuck compilation failed: reserved virtual memory tapes aren't supported on this platform");
+		using data_vector_t = helpers::non_bad_vector<uint8_t, data_vector_bucket_size>;
+#else
+		using data_vector_t = std::conditional_t<has_unchecked_tape, 
+		      helpers::reserved_vector<uint8_t, reserved_tape_size, ir::max_checkpoint_range(program.instructions)>,
+		      helpers::non_bad_vector<uint8_t, data_vector_bucket_size>>;
+#endif
+
+		/*
+		   With a prefix_step_budget, the input-free start of the program is run at compile-time (see ir::evaluate_prefix).
+		   The output it produced gets written in one go at the start of run(), the tape starts out in the state that the prefix left it in
+		   and the generated code starts running at prefix.resume_index instead of at the beginning.
+		   NOTE: That means run() expects the tape to be in that state, which the constructors and the reset functions take care of.
+		   Calling run() twice without resetting in between continues at the resume point instead of at the beginning.
+		   NOTE: The profile (if you have one) only contains what ran at runtime.
+		*/
+		static constexpr bool has_prefix = prefix_step_budget != 0;
+
+		static_assert(!has_prefix || is_tape_zeroed, "brainfuck compilation failed: prefix evaluation only works with initial_tape_t::ZEROED");
+
+		static constexpr size_t max_tape_length = has_unchecked_tape ? reserved_tape_size : (size_t)-1;
+
+		static constexpr ir::prefix_info_t prefix_info = ir::make_prefix_info(program, prefix_step_budget, max_tape_length);
+		static constexpr ir::prefix_t<prefix_info.tape_length, prefix_info.output_length> prefix = 
+			ir::make_prefix<prefix_info.tape_length, prefix_info.output_length>(program, prefix_step_budget, max_tape_length);
+
+		data_vector_t data = data_vector_t::create_nulled_out_vec(1);
+		uint8_t* data_end_ptr = data.data + data.length;
+		uint8_t* data_ptr = data.data;
+
+		static constexpr bool is_profiling = instrumentation == instrumentation_t::PROFILING;
+
+		[[no_unique_address]] std::conditional_t<is_profiling, helpers::profile_t<program_length>, helpers::empty_t> profile;
+
+		static constexpr bool is_resumable = execution == execution_t::RESUMABLE;
+
+		/*
+		   Where a suspended program continues (see resume()). We don't need a stack or anything for that, because every place in the program
+		   can be reached from the top with the generated code: resume_from<instruction_index>() runs the rest of the block, the rest of the loop
+		   around it, and so on. So all we have to remember is which resume_from to call, the tape and data_ptr are already in the right state.
+		   prefix_output_position is how much of the compile-time prefix's output was written already, and result is what the program returned
+		   if it got suspended after it was already done (in the final flush).
+		*/
+		struct suspension_t {
+			brainfuck_run_return_t (compiled_brainfuck_t::*resume_function)() noexcept = nullptr;
+			size_t prefix_output_position = 0;
+			brainfuck_run_return_t result = brainfuck_run_return_t::SUCCESS;
+		};
+
+		[[no_unique_address]] std::conditional_t<is_resumable, suspension_t, helpers::empty_t> suspension;
+
+		// NOTE: Expects a fresh tape (length of at least 1, all zeros) and copies the prefix tape into it.
+		// Without a prefix, that's just setting the pointers.
+		bool load_initial_tape() noexcept {
+			if constexpr (has_prefix) {
+				if (data.length < prefix_info.tape_length && !data.push_back_nulled_out(prefix_info.tape_length - data.length)) { return false; }
+				memcpy(data.data, prefix.tape, prefix_info.tape_length);
+			}
+			data_end_ptr = data.data + data.length;
+			data_ptr = data.data + prefix.data_ptr_index;
+			return true;
+		}
+
+		compiled_brainfuck_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback) : 
+			io_t(read_input_byte_callback, write_output_byte_callback)
+		{
+			// NOTE: Without any memory, run() reports ALLOCATION_FAILURE, same as when the initial allocation fails.
+			if constexpr (has_prefix) { if (!data.data || !load_initial_tape()) { data.reset_everything(); } }
+		}
+
+		/*
+		   Takes over an existing tape instead of allocating a new one. The tape has to look like a fresh one (length of at least 1, all zeros),
+		   which is exactly what release_tape() gives you. With initial_tape_t::ARBITRARY, the contents can be anything (the length still has to be at least 1). Together, these two let you reuse one tape for a lot of short-lived instances
+		   (see brainfuck_batch_runner_t) without ever moving an instance around.
+		*/
+		compiled_brainfuck_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback, data_vector_t&& tape) : 
+			io_t(read_input_byte_callback, write_output_byte_callback),
+			data(std::move(tape)), data_end_ptr(data.data + data.length), data_ptr(data.data)
+		{
+			if constexpr (has_prefix) { if (!data.data || !load_initial_tape()) { data.reset_everything(); } }
+		}
+
+		consteval compiled_brainfuck_t(compiled_brainfuck_t&& other) : 
+			io_t(other.read_input_byte, other.write_output_byte),
+			data(std::move(other.data)), data_end_ptr(other.data_end_ptr), data_ptr(other.data_ptr)
+		{ }
+
+		// NOTE: I forgot when this is going to be introduced, but I remember that this should (eventually) imply
+		// that the copy assignment operator is also deleted. So this one line does everything we need it to.
+		compiled_brainfuck_t(const compiled_brainfuck_t& other) = delete;
+
+		bool increment_data_ptr() noexcept {
+			if (++data_ptr == data_end_ptr) {
+				if (!data.push_back(0)) { return false; }
+				data_end_ptr = data.data + data.length;
+				data_ptr = data_end_ptr - 1;
+			}
+			return true;
+		}
+
+		bool decrement_data_ptr() noexcept {
+			// NOTE: We have to do it like this to avoid pointer underflow/overflow, which is super duper UB.
+			if (data_ptr == data.data) { return false; }
+			data_ptr--;
+			return true;
+		}
+
+		// NOTE: See helpers::move_data_ptr. Here, the delta and range are known at compile-time, so the checks that can't fail disappear.
+		template <ptrdiff_t delta, ptrdiff_t min, ptrdiff_t max>
+		bool move_data_ptr() noexcept { return helpers::move_data_ptr(data, data_ptr, data_end_ptr, delta, min, max); }
+
+		/*
+		   NOTE: You've been wondering why compiled switch statements (on my x86-64 machine)
+		   choose to load a target addr from memory and slow jump to that instead of slow jumping to an addr
+		   at a specific offset, which contains a fast (unconditional) jump to the target code.
+		   Basically it comes down to this question: Is a fast jump of memory access faster?
+		   Apparently, at least on my machine, memory access must be faster, or else this optimization wouldn't be done.
+		   I've done some research, and when the L1 cache is hit (which I guess is what the compiler is optimizing for here),
+		   the access time is just a tiny tad bit slower than talking to a register, so it's unbelievably fast.
+		   You might think fast jumps are faster because they must only take like 1 clock cycle right?
+		   That's not actually true, they can be slow (and I guess they are slower than L1 cache hits most of the time),
+		   since because of the way the CPU is pipelined, the CPU doesn't actually know if the jump instruction is
+		   conditional or unconditional when it first enters the pipe, it takes a few stages till it definitively figures that out.
+		   That means it still has to use the branch predictor, even for fast jumps, since it needs to keep fetching instructions
+		   somewhere and it has no other option than to predict where until it can correct.
+		   This adds overhead and makes even a fast jump undesirable in the face of a perfect memory access.
+		*/
+
+		template <size_t block_begin>
+		static constexpr size_t block_length = program.block_length(block_begin);
+
+		template <size_t block_begin>
+		static constexpr ir::statement_list_t<block_length<block_begin>> block_statements = ir::make_statement_list<block_length<block_begin>>(program, block_begin);
+
+		static constexpr ir::enclosing_loop_list_t<program_length> enclosing_loops = ir::make_enclosing_loop_list(program);
+
+		// NOTE: Clang refuses to instantiate fold expressions with more than 256 arguments (bracket depth limit),
+		// so we split big blocks into halves until they fit. This only adds a logarithmic amount of depth.
+		static constexpr size_t max_fold_length = 128;
+
+		/*
+		   This is the checkpoint check for unchecked tapes (min and max come from the checked_min and checked_max of the checkpoint instruction).
+		   It reports underflow and makes sure that everything that was touched since the last checkpoint is counted in the length.
+		   With checked tapes, every move already did all of this, so it's a no-op.
+		*/
+		template <ptrdiff_t min, ptrdiff_t max>
+		bool check_data_ptr() noexcept {
+			if constexpr (has_unchecked_tape) {
+				// NOTE: The pointer plus min and max is always inside of the mapping here (that's what the slack is for, see ir::max_checkpoint_range),
+				// so these comparisons are fine.
+				// We can't skip the first one if min is 0, since the unchecked moves could have put the pointer itself out of bounds.
+				if (data_ptr + min < data.data) { return false; }
+				if (data_ptr + max >= data_end_ptr) {
+					if (data_ptr + max >= data.data + data.capacity) { return false; }
+					data_end_ptr = data_ptr + max + 1;
+					data.length = data_end_ptr - data.data;
+				}
+			}
+			return true;
+		}
+
+		// NOTE: Makes sure that the cells from data_ptr + min to data_ptr + max exist, without moving the pointer. Returns false if they can't.
+		template <ptrdiff_t min, ptrdiff_t max>
+		bool reserve_range() noexcept {
+			if constexpr (has_unchecked_tape) { return check_data_ptr<min, max>(); }
+			else { return move_data_ptr<0, min, max>(); }
+		}
+
+		static constexpr bool is_suspension(brainfuck_run_return_t return_value) {
+			return return_value == brainfuck_run_return_t::NEEDS_INPUT || return_value == brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN;
+		}
+
+		// NOTE: ',' and '.'. If a resumable program has to stop here, it continues with this same instruction later (it didn't do anything yet).
+		template <size_t instruction_index>
+		brainfuck_run_return_t run_io(uint8_t* cell) noexcept {
+			brainfuck_run_return_t return_value = program.instructions[instruction_index].op == ir::op_t::INPUT ? this->input_to_cell(cell) : this->output_from_cell(*cell);
+			if constexpr (is_resumable) {
+				if (is_suspension(return_value)) { suspension.resume_function = &compiled_brainfuck_t::resume_from<instruction_index>; }
+			}
+			return return_value;
+		}
+
+		// NOTE: The part of a multiply loop that comes after the checks. origin is the loop's cell, which isn't 0.
+		template <size_t instruction_index>
+		void apply_multiply_loop(uint8_t* origin) noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[instruction_index];
+
+			uint8_t iterations = helpers::multiply_loop_iterations(instruction.value, *origin);
+			if constexpr (is_profiling) { profile.loop_iterations[instruction_index] += iterations; }
+			if constexpr (instruction.jump != instruction_index + 1) {
+				[origin, iterations]<size_t... target_indices>(std::index_sequence<target_indices...>) {
+					((origin[program.instructions[instruction_index + 1 + target_indices].offset] += 
+					  (uint8_t)(program.instructions[instruction_index + 1 + target_indices].value * iterations)), ...);
+				}(std::make_index_sequence<instruction.jump - instruction_index - 1>{});
+			}
+			*origin = 0;
+		}
+
+		template <size_t instruction_index>
+		brainfuck_run_return_t run_multiply_loop() noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[instruction_index];
+
+			if (*data_ptr == 0) { return brainfuck_run_return_t::SUCCESS; }
+			// NOTE: Even without targets (like in "[-<<>>]"), the original loop walked over this range, so it has to be checked.
+			if (!reserve_range<instruction.min, instruction.max>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			apply_multiply_loop<instruction_index>(data_ptr);
+			return brainfuck_run_return_t::SUCCESS;
+		}
+
+		/*
+		   The unchecked version of balanced loops (see ir::annotate_balanced_loops). The whole range of the loop was checked when we entered it,
+		   so nothing in here checks anything. Even better, the pointer doesn't move at all: every instruction knows at compile-time how far away
+		   from data_ptr its cell is (offset), so it's all data_ptr[offset] and the compiler can keep data_ptr in a register for the whole loop.
+		   Nested loops are balanced too, so they just continue with the offset that they start at.
+		   NOTE: If I/O fails, we move the pointer to where it would be before returning, so that it looks exactly like the checked version.
+		*/
+		template <size_t instruction_index, ptrdiff_t offset>
+		brainfuck_run_return_t run_unchecked_instruction() noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[instruction_index];
+			uint8_t* cell = data_ptr + offset;
+
+			if constexpr (instruction.op == ir::op_t::ADD) { *cell += (uint8_t)instruction.value; }
+
+			else if constexpr (instruction.op == ir::op_t::LOOP_BEGIN) {
+				while (*cell != 0) {
+					if constexpr (is_profiling) { profile.loop_iterations[instruction_index]++; }
+					brainfuck_run_return_t return_value = run_unchecked_block<instruction_index + 1, offset>();
+					if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				}
+			}
+
+			else if constexpr (instruction.op == ir::op_t::MULTIPLY_LOOP) { if (*cell != 0) { apply_multiply_loop<instruction_index>(cell); } }
+
+			else if constexpr (instruction.op == ir::op_t::INPUT || instruction.op == ir::op_t::OUTPUT) {
+				brainfuck_run_return_t return_value = run_io<instruction_index>(cell);
+				if (return_value != brainfuck_run_return_t::SUCCESS) { data_ptr = cell; }
+				return return_value;
+			}
+
+			// NOTE: MOVEs don't do anything, they're already part of the offsets. Balanced loops don't contain scans.
+			return brainfuck_run_return_t::SUCCESS;
+		}
+
+		template <size_t block_begin>
+		static constexpr ir::statement_offset_list_t<block_length<block_begin>> block_statement_offsets = 
+			ir::make_statement_offset_list<block_length<block_begin>>(program, block_begin);
+
+		template <size_t block_begin, ptrdiff_t block_offset, size_t first_statement, size_t statement_count>
+		brainfuck_run_return_t run_unchecked_statements() noexcept {
+			if constexpr (statement_count > max_fold_length) {
+				constexpr size_t first_half_count = statement_count / 2;
+				brainfuck_run_return_t return_value = run_unchecked_statements<block_begin, block_offset, first_statement, first_half_count>();
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				return run_unchecked_statements<block_begin, block_offset, first_statement + first_half_count, statement_count - first_half_count>();
+			}
+			else {
+				brainfuck_run_return_t return_value = brainfuck_run_return_t::SUCCESS;
+				[this, &return_value]<size_t... statement_indices>(std::index_sequence<statement_indices...>) {
+					(void)(((return_value = run_unchecked_instruction<block_statements<block_begin>.indices[first_statement + statement_indices], 
+						 block_offset + block_statement_offsets<block_begin>.offsets[first_statement + statement_indices]>()) == brainfuck_run_return_t::SUCCESS) && ...);
+				}(std::make_index_sequence<statement_count>{});
+				return return_value;
+			}
+		}
+
+		template <size_t block_begin, ptrdiff_t block_offset>
+		brainfuck_run_return_t run_unchecked_block() noexcept { return run_unchecked_statements<block_begin, block_offset, 0, block_length<block_begin>>(); }
+
+		template <size_t loop_begin>
+		brainfuck_run_return_t run_loop() noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[loop_begin];
+			constexpr ir::instruction_t loop_end = program.instructions[instruction.jump];
+
+			// NOTE: One check for the whole loop instead of one per move. If the range check fails (which doesn't necessarily mean that the loop
+			// is going to fail, the failing part might never run), the checked version below reports the error at exactly the right place.
+			if constexpr (instruction.value == 1) {
+				if (*data_ptr == 0) { return brainfuck_run_return_t::SUCCESS; }
+				if (reserve_range<instruction.min, instruction.max>()) {
+					do {
+						if constexpr (is_profiling) { profile.loop_iterations[loop_begin]++; }
+						brainfuck_run_return_t return_value = run_unchecked_block<loop_begin + 1, 0>();
+						if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+					} while (*data_ptr != 0);
+					return brainfuck_run_return_t::SUCCESS;
+				}
+			}
+
+			while (*data_ptr != 0) {
+				if constexpr (is_profiling) { profile.loop_iterations[loop_begin]++; }
+				brainfuck_run_return_t return_value = run_block<loop_begin + 1>();
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				if (!check_data_ptr<loop_end.checked_min, loop_end.checked_max>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			}
+			return brainfuck_run_return_t::SUCCESS;
+		}
+
+		template <size_t instruction_index>
+		brainfuck_run_return_t run_instruction() noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[instruction_index];
+
+			if constexpr (ir::is_checkpoint(instruction.op)) {
+				if (!check_data_ptr<instruction.checked_min, instruction.checked_max>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			}
+
+			if constexpr (instruction.op == ir::op_t::MOVE) {
+				if constexpr (has_unchecked_tape) { data_ptr += instruction.value; }
+				else if (!move_data_ptr<instruction.value, instruction.min, instruction.max>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			}
+
+			// NOTE: Don't worry, the brainfuck program can totally overflow the data values without causing UB. It's ok.
+			else if constexpr (instruction.op == ir::op_t::ADD) { *data_ptr += (uint8_t)instruction.value; }
+
+			else if constexpr (instruction.op == ir::op_t::LOOP_BEGIN) { return run_loop<instruction_index>(); }
+
+			else if constexpr (instruction.op == ir::op_t::MULTIPLY_LOOP) { return run_multiply_loop<instruction_index>(); }
+
+			else if constexpr (instruction.op == ir::op_t::SCAN_RIGHT) {
+				if (*data_ptr == 0) { return brainfuck_run_return_t::SUCCESS; }
+				[[maybe_unused]] size_t scan_begin = data_ptr - data.data;
+				if constexpr (has_unchecked_tape) {
+					// NOTE: Same as helpers::scan_right, except that the reserved tape doesn't have to grow, the first cell past the end is already there.
+					uint8_t* zero_ptr = helpers::find_zero_forward(data_ptr, data_end_ptr);
+					if (zero_ptr) { data_ptr = zero_ptr; }
+					else {
+						data_ptr = data_end_ptr;
+						if (!check_data_ptr<0, 0>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+					}
+				}
+				else if (!helpers::scan_right(data, data_ptr, data_end_ptr)) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+				if constexpr (is_profiling) { profile.loop_iterations[instruction_index] += (data_ptr - data.data) - scan_begin; }
+			}
+
+			else if constexpr (instruction.op == ir::op_t::SCAN_LEFT) {
+				if (*data_ptr == 0) { return brainfuck_run_return_t::SUCCESS; }
+				uint8_t* zero_ptr = helpers::find_zero_backward(data.data, data_ptr);
+				if (!zero_ptr) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+				if constexpr (is_profiling) { profile.loop_iterations[instruction_index] += data_ptr - zero_ptr; }
+				data_ptr = zero_ptr;
+			}
+
+			else if constexpr (instruction.op == ir::op_t::INPUT || instruction.op == ir::op_t::OUTPUT) { return run_io<instruction_index>(data_ptr); }
+
+			return brainfuck_run_return_t::SUCCESS;
+		}
+
+		template <size_t block_begin, size_t first_statement, size_t statement_count>
+		brainfuck_run_return_t run_statements() noexcept {
+			if constexpr (statement_count > max_fold_length) {
+				constexpr size_t first_half_count = statement_count / 2;
+				brainfuck_run_return_t return_value = run_statements<block_begin, first_statement, first_half_count>();
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				return run_statements<block_begin, first_statement + first_half_count, statement_count - first_half_count>();
+			}
+			else {
+				brainfuck_run_return_t return_value = brainfuck_run_return_t::SUCCESS;
+				[this, &return_value]<size_t... statement_indices>(std::index_sequence<statement_indices...>) {
+					(void)(((return_value = run_instruction<block_statements<block_begin>.indices[first_statement + statement_indices]>()) == brainfuck_run_return_t::SUCCESS) && ...);
+				}(std::make_index_sequence<statement_count>{});
+				return return_value;
+			}
+		}
+
+		template <size_t block_begin>
+		brainfuck_run_return_t run_block() noexcept { return run_statements<block_begin, 0, block_length<block_begin>>(); }
+
+		/*
+		   Runs the block from first_statement to its end. We only run up to the next multiple of max_fold_length here and leave the rest
+		   to the version that starts there. That way, all the places we can resume from share the code for the rest of the block,
+		   instead of every one of them getting its own copy (which would be quadratic in the block length for programs with lots of I/O).
+		*/
+		template <size_t block_begin, size_t first_statement>
+		brainfuck_run_return_t run_statements_from() noexcept {
+			constexpr size_t chunk_end = (first_statement / max_fold_length + 1) * max_fold_length;
+			if constexpr (chunk_end >= block_length<block_begin>) { return run_statements<block_begin, first_statement, block_length<block_begin> - first_statement>(); }
+			else {
+				brainfuck_run_return_t return_value = run_statements<block_begin, first_statement, chunk_end - first_statement>();
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				return run_statements_from<block_begin, chunk_end>();
+			}
+		}
+
+		/*
+		   Runs the program starting at any instruction (except MULTIPLY_ADDs), this is how we pick up where the compile-time prefix stopped
+		   and where a suspended program stopped.
+		   That's the rest of the block the instruction is in, and if that block is a loop body, the rest of that loop (starting with
+		   its back-edge check) and then the rest of the block around the loop, and so on until we're back at the top level.
+		   NOTE: resume_from<0>() is exactly run_block<0>().
+		*/
+		template <size_t instruction_index>
+		brainfuck_run_return_t resume_from() noexcept {
+			// NOTE: A LOOP_END is the end of its loop's body, everything else is in the body of the loop around it (or at the top level).
+			constexpr size_t loop_begin = program.instructions[instruction_index].op == ir::op_t::LOOP_END ? 
+				program.instructions[instruction_index].jump : enclosing_loops.indices[instruction_index];
+			constexpr size_t block_begin = loop_begin == program_length ? 0 : loop_begin + 1;
+			constexpr size_t position = program.statement_position(block_begin, instruction_index);
+
+			brainfuck_run_return_t return_value = run_statements_from<block_begin, position>();
+			if constexpr (loop_begin != program_length) {
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				constexpr ir::instruction_t loop_end = program.instructions[program.instructions[loop_begin].jump];
+				if (!check_data_ptr<loop_end.checked_min, loop_end.checked_max>()) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+				return_value = run_loop<loop_begin>();
+				if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				return resume_from<program.next_statement(loop_begin)>();
+			}
+			return return_value;
+		}
+
+		brainfuck_run_return_t run_program() noexcept {
+			if constexpr (prefix_info.output_length != 0) {
+				// NOTE: Byte by byte, so that we know how far we got if we have to stop in the middle of it.
+				if constexpr (is_resumable) {
+					for (; suspension.prefix_output_position < prefix_info.output_length; suspension.prefix_output_position++) {
+						brainfuck_run_return_t return_value = this->output_from_cell(prefix.output[suspension.prefix_output_position]);
+						if (return_value == brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN) { suspension.resume_function = &compiled_brainfuck_t::run_program; }
+						if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+					}
+				}
+				else {
+					brainfuck_run_return_t return_value = this->output_bytes(prefix.output, prefix_info.output_length);
+					if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				}
+			}
+			return resume_from<prefix.resume_index>();
+		}
+
+		// NOTE: This is where a program that got suspended after it was done (in the final flush) continues, there's nothing left to run.
+		brainfuck_run_return_t return_result() noexcept { return suspension.result; }
+
+		// NOTE: With batched output, the output that's still in the buffer gets flushed on every return, no matter how the program ended.
+		// If the program failed and the flush fails too, the program's failure is the one that gets reported.
+		// Suspended programs are the exception, their output stays in the buffer until they continue. If the final flush has to wait,
+		// the program gets suspended there and reports how it ended once the flush went through.
+		brainfuck_run_return_t finish_run(brainfuck_run_return_t return_value) noexcept {
+			// NOTE: END is a checkpoint too. It's here instead of in run_program() so that resumed programs get it as well.
+			constexpr ir::instruction_t end = program.instructions[program_length - 1];
+			if (return_value == brainfuck_run_return_t::SUCCESS && !check_data_ptr<end.checked_min, end.checked_max>()) { return_value = brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			if constexpr (is_profiling) { if (data.length > profile.max_tape_length) { profile.max_tape_length = data.length; } }
+			if constexpr (is_resumable) {
+				if (is_suspension(return_value)) { return return_value; }
+				brainfuck_run_return_t flush_return_value = this->write_buffered_output();
+				if (flush_return_value == brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN) {
+					suspension.result = return_value;
+					suspension.resume_function = &compiled_brainfuck_t::return_result;
+					return flush_return_value;
+				}
+				return return_value == brainfuck_run_return_t::SUCCESS ? flush_return_value : return_value;
+			}
+			if (!this->flush_output() && return_value == brainfuck_run_return_t::SUCCESS) { return brainfuck_run_return_t::OUTPUT_FAILURE; }
+			return return_value;
+		}
+
+		brainfuck_run_return_t run() noexcept {
+			if (!data.data) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			if constexpr (is_profiling) { profile.run_count++; }
+			if constexpr (is_resumable) { suspension = { }; }
+			return finish_run(run_program());
+		}
+
+		/*
+		   Continues a resumable program that returned NEEDS_INPUT or NEEDS_OUTPUT_DRAIN, exactly where it stopped: the ',' or '.' that
+		   couldn't go through is simply done again (so the functor gets called again, with the same output in the case of '.').
+		   You can call it as often as you want, it returns NEEDS_INPUT/NEEDS_OUTPUT_DRAIN again until the functors are ready.
+		   Everything else is the same as with run(), including the return values. The whole state lives in the instance,
+		   so one thread can drive as many suspended programs as it wants (no stacks, no threads).
+		   NOTE: If the program isn't suspended (it finished, failed, or never ran), this does nothing and returns SUCCESS.
+		   A reset or a new run() forgets about the suspension.
+		*/
+		brainfuck_run_return_t resume() noexcept {
+			static_assert(is_resumable, "resume() is only available with execution_t::RESUMABLE");
+			if (!suspension.resume_function) { return brainfuck_run_return_t::SUCCESS; }
+			brainfuck_run_return_t (compiled_brainfuck_t::*resume_function)() noexcept = suspension.resume_function;
+			suspension.resume_function = nullptr;
+			return finish_run((this->*resume_function)());
+		}
+
+		bool is_suspended() const noexcept {
+			static_assert(is_resumable, "is_suspended() is only available with execution_t::RESUMABLE");
+			return suspension.resume_function != nullptr;
+		}
+
+		bool reset_state_keep_vec_reserved() noexcept {
+			if constexpr (is_resumable) { suspension = { }; }
+			data.release_length_keep_reserve();
+			if (!data.push_back(0)) { return false; }
+			return load_initial_tape();
+		}
+
+		bool reset_state_unreserve_vec() noexcept {
+			if constexpr (is_resumable) { suspension = { }; }
+			data.reset_everything();
+			if (!data.push_back(0)) { return false; }
+			return load_initial_tape();
+		}
+
+		// NOTE: Resets the tape (keeping the memory) and hands it over to the caller. The instance is unusable afterwards.
+		// The tape is a fresh one (one zero cell), even with a prefix.
+		data_vector_t release_tape() noexcept {
+			data.release_length_keep_reserve();
+			data.push_back(0);
+			data_end_ptr = nullptr;
+			data_ptr = nullptr;
+			return std::move(data);
+		}
+
+		// NOTE: The profile isn't touched by the reset functions, so it adds up over all runs until you call this.
+		void reset_profile() noexcept {
+			static_assert(is_profiling, "reset_profile() is only available with instrumentation_t::PROFILING");
+			memset(&profile, 0, sizeof(profile));
+		}
+
+		/*
+		   How often the instruction ran, derived from the iteration count of the loop around it. Loops count how often they were reached
+		   (whether the body ran or not), a LOOP_END counts once per iteration of its loop. MULTIPLY_ADDs are part of their multiply loop, so they're always 0 (and so is END).
+		   NOTE: If a run fails (ALLOCATION_FAILURE, I/O failure), the rest of the block that it failed in is counted as if it ran.
+		*/
+		uint64_t profiled_execution_count(size_t instruction_index) const noexcept {
+			static_assert(is_profiling, "profiled_execution_count() is only available with instrumentation_t::PROFILING");
+			const ir::instruction_t& instruction = program.instructions[instruction_index];
+			// NOTE: END isn't in the source, it's just there to mark the end of the program.
+			if (instruction.op == ir::op_t::MULTIPLY_ADD || instruction.op == ir::op_t::END) { return 0; }
+			if (instruction.op == ir::op_t::LOOP_END) { return profile.loop_iterations[instruction.jump]; }
+			size_t enclosing_loop = enclosing_loops.indices[instruction_index];
+			return enclosing_loop == program_length ? profile.run_count : profile.loop_iterations[enclosing_loop];
+		}
+
+		// NOTE: The moves don't need a counter of their own for this, their execution count times their (folded) distance is enough.
+		// That means a run like ">><" counts as 1 cell, not 3. Scans count the cells they skipped over as their iterations.
+		uint64_t profiled_pointer_movement() const noexcept {
+			static_assert(is_profiling, "profiled_pointer_movement() is only available with instrumentation_t::PROFILING");
+			uint64_t result = 0;
+			for (size_t i = 0; i < program_length; i++) {
+				const ir::instruction_t& instruction = program.instructions[i];
+				if (instruction.op == ir::op_t::MOVE) { result += profiled_execution_count(i) * (uint64_t)(instruction.value < 0 ? -instruction.value : instruction.value); }
+				else if (instruction.op == ir::op_t::SCAN_RIGHT || instruction.op == ir::op_t::SCAN_LEFT) { result += profile.loop_iterations[i]; }
+			}
+			return result;
+		}
+
+		static constexpr bool is_profiled_loop(ir::op_t op) {
+			return op == ir::op_t::LOOP_BEGIN || op == ir::op_t::MULTIPLY_LOOP || op == ir::op_t::SCAN_RIGHT || op == ir::op_t::SCAN_LEFT;
+		}
+
+		/*
+		   Prints the profile in a human-readable form:
+		   	--> the totals (executed instructions, maximum tape length, pointer movement)
+			--> the executed instructions per source line (only lines that ran at all)
+			--> the hottest loops ranked by iteration count, with line, column and src_offset of their '['
+		*/
+		void print_profile(FILE* file, size_t hottest_loop_count = 10) const noexcept {
+			static_assert(is_profiling, "print_profile() is only available with instrumentation_t::PROFILING");
+			std::string_view source = source_code_const_string_original;
+
+			uint64_t executed_instruction_count = 0;
+			for (size_t i = 0; i < program_length; i++) { executed_instruction_count += profiled_execution_count(i); }
+			fprintf(file, "executed instructions: %llu\n", (unsigned long long)executed_instruction_count);
+			fprintf(file, "max tape length: %zu cells\n", profile.max_tape_length);
+			fprintf(file, "pointer movement: %llu cells\n", (unsigned long long)profiled_pointer_movement());
+
+			// NOTE: The instructions are sorted by src_offset, so we can walk through the source and the instructions at the same time.
+			// The only exception are peeled loops (see ir::propagate_known_values), their copies all get counted on the line the first copy ends on.
+			fprintf(file, "\nexecuted instructions per line:\n");
+			size_t line = 1;
+			size_t source_position = 0;
+			uint64_t line_count = 0;
+			for (size_t i = 0; i < program_length; i++) {
+				for (; source_position < program.instructions[i].src_offset && source_position < source.length(); source_position++) {
+					if (source[source_position] != '\n') { continue; }
+					if (line_count) { fprintf(file, "  line %zu: %llu\n", line, (unsigned long long)line_count); }
+					line_count = 0;
+					line++;
+				}
+				line_count += profiled_execution_count(i);
+			}
+			if (line_count) { fprintf(file, "  line %zu: %llu\n", line, (unsigned long long)line_count); }
+
+			// NOTE: Selects the next hottest loop every time instead of sorting, which is fine for the handful of loops we print.
+			// Ties are broken by the instruction index so that every loop gets printed at most once.
+			fprintf(file, "\nhottest loops:\n");
+			size_t previous = (size_t)-1;
+			for (size_t rank = 1; rank <= hottest_loop_count; rank++) {
+				size_t hottest = (size_t)-1;
+				for (size_t i = 0; i < program_length; i++) {
+					if (!is_profiled_loop(program.instructions[i].op) || profile.loop_iterations[i] == 0) { continue; }
+					if (previous != (size_t)-1 && (profile.loop_iterations[i] > profile.loop_iterations[previous] || 
+								       (profile.loop_iterations[i] == profile.loop_iterations[previous] && i <= previous))) { continue; }
+					if (hottest == (size_t)-1 || profile.loop_iterations[i] > profile.loop_iterations[hottest]) { hottest = i; }
+				}
+				if (hottest == (size_t)-1) { break; }
+				previous = hottest;
+
+				size_t src_offset = program.instructions[hottest].src_offset;
+				size_t loop_line = 1;
+				size_t line_begin = 0;
+				for (size_t j = 0; j < src_offset; j++) { if (source[j] == '\n') { loop_line++; line_begin = j + 1; } }
+				const char* kind = "loop";
+				if (program.instructions[hottest].op == ir::op_t::MULTIPLY_LOOP) { kind = "multiply loop"; }
+				else if (program.instructions[hottest].op != ir::op_t::LOOP_BEGIN) { kind = "scan loop"; }
+				fprintf(file, "  %zu. line %zu, column %zu (src_offset %zu, %s): %llu iterations, reached %llu times\n", 
+					rank, loop_line, src_offset - line_begin + 1, src_offset, kind, 
+					(unsigned long long)profile.loop_iterations[hottest], (unsigned long long)profiled_execution_count(hottest));
+			}
+		}
+	};
+
+#if defined(__GNUC__) || defined(__clang__)
+#define META_BRAINFUCK_COMPILER_HAS_COMPUTED_GOTO
+#endif
+
+	/*
+	   Interpreter for sources that are only known at runtime (the compiled_brainfuck_t needs the source at compile-time).
+	   load() runs the source through the same IR pipeline as the compiler (it's all constexpr, so it works at runtime too)
+	   and lowers the result into a flat bytecode array with relative jumps. run() then executes that bytecode.
+	   NOTE: Where the compiler supports it (GCC and Clang), the bytecode is direct-threaded: every instruction holds the address
+	   of its handler (computed goto) and every handler jumps straight to the handler of the next instruction.
+	   There is no central dispatch loop, which means every handler gets its own indirect jump, which is a lot easier on the branch predictor.
+	   Everywhere else we fall back to a normal switch in a loop.
+	   The tape, the functors and the return codes work exactly like in compiled_brainfuck_t.
+	*/
+	template <typename input_functor_t, typename output_functor_t, size_t data_vector_bucket_size = META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, 
+		 size_t io_buffer_size = META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT,
+		 typename std::enable_if<(has_per_byte_input<input_functor_t> || has_batched_input<input_functor_t>) &&
+			 (has_per_byte_output<output_functor_t> || has_batched_output<output_functor_t>), bool>::type = true>
+	class interpreted_brainfuck_t : public helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size> {
+	public:
+		using io_t = helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size>;
+
+		struct bytecode_instruction_t {
+			// NOTE: Only filled in with computed goto, see resolve_handlers.
+			const void* handler = nullptr;
+			// NOTE: ADD, MOVE: delta, LOOP_BEGIN, LOOP_END, MULTIPLY_LOOP: relative jump, MULTIPLY_ADD: target offset.
+			int32_t argument = 0;
+			// NOTE: MOVE, MULTIPLY_LOOP: the range of cells that gets touched.
+			int32_t min = 0;
+			int32_t max = 0;
+			// NOTE: MULTIPLY_LOOP: origin delta (+1/-1), MULTIPLY_ADD: factor.
+			uint8_t value = 0;
+			ir::op_t op = ir::op_t::END;
+		};
+
+		helpers::non_bad_vector<uint8_t, data_vector_bucket_size> data = helpers::non_bad_vector<uint8_t, data_vector_bucket_size>::create_nulled_out_vec(1);
+		uint8_t* data_end_ptr = data.data + data.length;
+		uint8_t* data_ptr = data.data;
+
+		bytecode_instruction_t* bytecode = nullptr;
+		size_t bytecode_length = 0;
+		bool handlers_resolved = false;
+
+		// NOTE: The tape outlives load(), so the optimizations only get to assume a zeroed tape until something has run on it (see ir::compile).
+		// The reset functions make it fresh again. If you write to data yourself, set this to false.
+		bool is_tape_fresh = true;
+
+		interpreted_brainfuck_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback) : 
+			io_t(read_input_byte_callback, write_output_byte_callback)
+		{ }
+
+		interpreted_brainfuck_t(const interpreted_brainfuck_t& other) = delete;
+
+		~interpreted_brainfuck_t() { free(bytecode); }
+
+		/*
+		   Compiles the source into bytecode, replacing whatever was loaded before. Doesn't touch the tape, the new program continues on
+		   whatever the previous ones left there.
+		   Returns NONE on success. If it fails, nothing is loaded anymore (running then just succeeds without doing anything).
+		   NOTE: The bytecode uses 32-bit offsets, sources that would need bigger ones are reported as ALLOCATION_FAILURE.
+		*/
+		ir::parse_error_t load(std::string_view source) noexcept {
+			free(bytecode);
+			bytecode = nullptr;
+			bytecode_length = 0;
+			handlers_resolved = false;
+
+			ir::instruction_buffer_t program = ir::compile(source, is_tape_fresh);
+			if (program.error != ir::parse_error_t::NONE) { return program.error; }
+
+			bytecode = (bytecode_instruction_t*)malloc(program.length * sizeof(bytecode_instruction_t));
+			if (!bytecode) { return ir::parse_error_t::ALLOCATION_FAILURE; }
+			for (size_t i = 0; i < program.length; i++) {
+				const ir::instruction_t& instruction = program[i];
+				bytecode_instruction_t& result = *new (bytecode + i) bytecode_instruction_t;
+				result.op = instruction.op;
+				int64_t argument = 0;
+				switch (instruction.op) {
+				case ir::op_t::ADD: argument = instruction.value; break;
+				case ir::op_t::MOVE: argument = instruction.value; break;
+				case ir::op_t::LOOP_BEGIN: case ir::op_t::LOOP_END: case ir::op_t::MULTIPLY_LOOP: argument = (int64_t)instruction.jump - (int64_t)i; break;
+				case ir::op_t::MULTIPLY_ADD: argument = instruction.offset; break;
+				default: break;
+				}
+				if (argument != (int32_t)argument || instruction.min != (int32_t)instruction.min || instruction.max != (int32_t)instruction.max) {
+					free(bytecode);
+					bytecode = nullptr;
+					return ir::parse_error_t::ALLOCATION_FAILURE;
+				}
+				result.argument = argument;
+				result.min = instruction.min;
+				result.max = instruction.max;
+				result.value = instruction.value;
+			}
+			bytecode_length = program.length;
+			return ir::parse_error_t::NONE;
+		}
+
+		// NOTE: See helpers::move_data_ptr, the delta and range are only known at runtime here.
+		bool move_data_ptr(ptrdiff_t delta, ptrdiff_t min, ptrdiff_t max) noexcept { return helpers::move_data_ptr(data, data_ptr, data_end_ptr, delta, min, max); }
+
+		brainfuck_run_return_t run_bytecode() noexcept {
+			bytecode_instruction_t* ip = bytecode;
+
+#ifdef META_BRAINFUCK_COMPILER_HAS_COMPUTED_GOTO
+			// NOTE: Has to be in the same order as ir::op_t.
+			static const void* const handlers[] = {
+				&&END_handler, &&ADD_handler, &&MOVE_handler, &&INPUT_handler, &&OUTPUT_handler, &&LOOP_BEGIN_handler, &&LOOP_END_handler, 
+				&&MULTIPLY_LOOP_handler, &&MULTIPLY_ADD_handler, &&SCAN_RIGHT_handler, &&SCAN_LEFT_handler
+			};
+			if (!handlers_resolved) {
+				for (size_t i = 0; i < bytecode_length; i++) { bytecode[i].handler = handlers[(size_t)bytecode[i].op]; }
+				handlers_resolved = true;
+			}
+#define META_BRAINFUCK_INTERPRETER_HANDLER(op) op##_handler:
+#define META_BRAINFUCK_INTERPRETER_DISPATCH(new_ip) do { ip = (new_ip); goto *ip->handler; } while (false)
+			goto *ip->handler;
+			{
+#else
+#define META_BRAINFUCK_INTERPRETER_HANDLER(op) case ir::op_t::op:
+#define META_BRAINFUCK_INTERPRETER_DISPATCH(new_ip) do { ip = (new_ip); goto dispatch; } while (false)
+			dispatch:
+			switch (ip->op) {
+#endif
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(ADD)
+				// NOTE: Don't worry, the brainfuck program can totally overflow the data values without causing UB. It's ok.
+				*data_ptr += (uint8_t)ip->argument;
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(MOVE)
+				if (!move_data_ptr(ip->argument, ip->min, ip->max)) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(LOOP_BEGIN)
+				// NOTE: ip + argument is the LOOP_END, so if the cell is 0, this goes straight to the instruction after it without running the LOOP_END.
+				META_BRAINFUCK_INTERPRETER_DISPATCH(*data_ptr == 0 ? ip + ip->argument + 1 : ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(LOOP_END)
+				META_BRAINFUCK_INTERPRETER_DISPATCH(*data_ptr != 0 ? ip + ip->argument + 1 : ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(MULTIPLY_LOOP)
+				if (*data_ptr != 0) {
+					uint8_t iterations = helpers::multiply_loop_iterations(ip->value, *data_ptr);
+					if (!move_data_ptr(0, ip->min, ip->max)) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+					for (bytecode_instruction_t* target = ip + 1; target != ip + ip->argument; target++) { 
+						data_ptr[target->argument] += (uint8_t)(target->value * iterations);
+					}
+					*data_ptr = 0;
+				}
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + ip->argument);
+
+			// NOTE: These are always skipped over by their MULTIPLY_LOOP.
+			META_BRAINFUCK_INTERPRETER_HANDLER(MULTIPLY_ADD)
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(SCAN_RIGHT)
+				if (*data_ptr != 0 && !helpers::scan_right(data, data_ptr, data_end_ptr)) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(SCAN_LEFT)
+				if (*data_ptr != 0) {
+					uint8_t* zero_ptr = helpers::find_zero_backward(data.data, data_ptr);
+					if (!zero_ptr) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+					data_ptr = zero_ptr;
+				}
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(INPUT)
+				{
+					brainfuck_run_return_t return_value = this->input_to_cell(data_ptr);
+					if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				}
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(OUTPUT)
+				{
+					brainfuck_run_return_t return_value = this->output_from_cell(*data_ptr);
+					if (return_value != brainfuck_run_return_t::SUCCESS) { return return_value; }
+				}
+				META_BRAINFUCK_INTERPRETER_DISPATCH(ip + 1);
+
+			META_BRAINFUCK_INTERPRETER_HANDLER(END)
+				return brainfuck_run_return_t::SUCCESS;
+			}
+
+#undef META_BRAINFUCK_INTERPRETER_HANDLER
+#undef META_BRAINFUCK_INTERPRETER_DISPATCH
+			return brainfuck_run_return_t::SUCCESS;
+		}
+
+		brainfuck_run_return_t run() noexcept {
+			if (!data.data) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			if (!bytecode) { return brainfuck_run_return_t::SUCCESS; }
+			is_tape_fresh = false;
+			brainfuck_run_return_t return_value = run_bytecode();
+			if (!this->flush_output() && return_value == brainfuck_run_return_t::SUCCESS) { return brainfuck_run_return_t::OUTPUT_FAILURE; }
+			return return_value;
+		}
+
+		bool reset_state_keep_vec_reserved() noexcept {
+			data.release_length_keep_reserve();
+			if (!data.push_back(0)) { return false; }
+			data_ptr = data.data;
+			data_end_ptr = data_ptr + 1;
+			is_tape_fresh = true;
+			return true;
+		}
+
+		bool reset_state_unreserve_vec() noexcept {
+			data.reset_everything();
+			if (!data.push_back(0)) { return false; }
+			data_ptr = data.data;
+			data_end_ptr = data_ptr + 1;
+			is_tape_fresh = true;
+			return true;
+		}
+	};
+
+#ifdef META_BRAINFUCK_COMPILER_HAS_JIT
+	/*
+	   JIT for sources that are only known at runtime, x86-64 Linux only (META_BRAINFUCK_COMPILER_HAS_JIT).
+	   load() runs the source through the same IR pipeline as the compiler and emits native code for it into an mmapped buffer.
+	   Same functors, return codes and reset functions as compiled_brainfuck_t, so you can swap one for the other.
+	   Register layout of the generated code (all callee-saved, so the stubs don't mess with them):
+	   	--> rbx: this, r15: &jit_context, r12: data pointer, r13: start of the tape, r14: end of the tape
+	   Everything that isn't simple pointer arithmetic (growing the tape, scans, I/O) goes through the static *_stub functions.
+	   The tape stubs work on jit_context, so the generated code stores r12 before calling them and reloads r12-r14 afterwards.
+	*/
+	template <typename input_functor_t, typename output_functor_t, size_t data_vector_bucket_size = META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, 
+		 size_t io_buffer_size = META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT,
+		 typename std::enable_if<(has_per_byte_input<input_functor_t> || has_batched_input<input_functor_t>) &&
+			 (has_per_byte_output<output_functor_t> || has_batched_output<output_functor_t>), bool>::type = true>
+	class jitted_brainfuck_t : public helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size> {
+	public:
+		using io_t = helpers::brainfuck_io_t<input_functor_t, output_functor_t, io_buffer_size>;
+
+		// NOTE: The generated code accesses this through fixed offsets, don't reorder.
+		struct jit_context_t {
+			uint8_t* data_ptr;
+			uint8_t* data_begin;
+			uint8_t* data_end;
+		};
+
+		using jitted_function_t = uint32_t (*)(jitted_brainfuck_t* self, jit_context_t* context);
+
+		helpers::non_bad_vector<uint8_t, data_vector_bucket_size> data = helpers::non_bad_vector<uint8_t, data_vector_bucket_size>::create_nulled_out_vec(1);
+		uint8_t* data_end_ptr = data.data + data.length;
+		uint8_t* data_ptr = data.data;
+
+		jit_context_t jit_context;
+
+		uint8_t* code = nullptr;
+		size_t code_capacity = 0;
+		size_t code_length = 0;
+		// NOTE: The function doesn't start at the beginning of the code, the shared exit sequence comes first (see emit_program).
+		jitted_function_t entry_point = nullptr;
+
+		// NOTE: Same as with the interpreter, the optimizations only get to assume a zeroed tape until something has run on it.
+		bool is_tape_fresh = true;
+
+		jitted_brainfuck_t(const input_functor_t& read_input_byte_callback, const output_functor_t& write_output_byte_callback) : 
+			io_t(read_input_byte_callback, write_output_byte_callback)
+		{ }
+
+		jitted_brainfuck_t(const jitted_brainfuck_t& other) = delete;
+
+		~jitted_brainfuck_t() { release_code(); }
+
+		void release_code() noexcept {
+			if (code) { munmap(code, code_capacity); }
+			code = nullptr;
+			code_capacity = 0;
+			code_length = 0;
+			entry_point = nullptr;
+		}
+
+		void load_context() noexcept {
+			data_ptr = jit_context.data_ptr;
+			data_end_ptr = jit_context.data_end;
+		}
+
+		void store_context() noexcept { jit_context = { data_ptr, data.data, data_end_ptr }; }
+
+		// NOTE: Only called when the inline check in the generated code fails, so this is the slow path.
+		static bool check_range_stub(jitted_brainfuck_t* self, ptrdiff_t min, ptrdiff_t max) noexcept {
+			self->load_context();
+			bool result = helpers::move_data_ptr(self->data, self->data_ptr, self->data_end_ptr, 0, min, max);
+			self->store_context();
+			return result;
+		}
+
+		static bool scan_right_stub(jitted_brainfuck_t* self) noexcept {
+			self->load_context();
+			bool result = helpers::scan_right(self->data, self->data_ptr, self->data_end_ptr);
+			self->store_context();
+			return result;
+		}
+
+		static bool scan_left_stub(jitted_brainfuck_t* self) noexcept {
+			self->load_context();
+			uint8_t* zero_ptr = helpers::find_zero_backward(self->data.data, self->data_ptr);
+			if (zero_ptr) { self->data_ptr = zero_ptr; }
+			self->store_context();
+			return zero_ptr;
+		}
+
+		static uint32_t input_stub(jitted_brainfuck_t* self, uint8_t* cell) noexcept { return (uint32_t)self->input_to_cell(cell); }
+
+		static uint32_t output_stub(jitted_brainfuck_t* self, uint8_t* cell) noexcept { return (uint32_t)self->output_from_cell(*cell); }
+
+		template <typename... bytes_t>
+		void emit(bytes_t... bytes) noexcept { ((code[code_length++] = (uint8_t)bytes), ...); }
+
+		void emit_int32(int32_t value) noexcept { memcpy(code + code_length, &value, sizeof(value)); code_length += sizeof(value); }
+
+		void emit_int64(uint64_t value) noexcept { memcpy(code + code_length, &value, sizeof(value)); code_length += sizeof(value); }
+
+		void patch_int32(size_t position, int32_t value) noexcept { memcpy(code + position, &value, sizeof(value)); }
+
+		// NOTE: Emits a rel32 that jumps to target (relative to the end of the rel32 itself).
+		void emit_jump_target(size_t target) noexcept { emit_int32((int32_t)((ptrdiff_t)target - (ptrdiff_t)(code_length + 4))); }
+
+		template <typename function_t>
+		void emit_call(function_t function) noexcept {
+			emit(0x48, 0xB8); emit_int64((uint64_t)(uintptr_t)function);		// mov rax, function
+			emit(0xFF, 0xD0);							// call rax
+		}
+
+		// NOTE: Exits with the given return code if the stub that was just called returned false.
+		void emit_exit_if_false(brainfuck_run_return_t return_value) noexcept {
+			emit(0x84, 0xC0);							// test al, al
+			emit(0x75, 0x0A);							// jnz +10
+			emit(0xB8); emit_int32((int32_t)return_value);				// mov eax, return_value
+			emit(0xE9); emit_jump_target(0);					// jmp exit
+		}
+
+		void emit_store_data_ptr() noexcept { emit(0x4D, 0x89, 0x27); }		// mov [r15], r12
+
+		void emit_reload_context() noexcept {
+			emit(0x4D, 0x8B, 0x27);							// mov r12, [r15]
+			emit(0x4D, 0x8B, 0x6F, 0x08);						// mov r13, [r15 + 8]
+			emit(0x4D, 0x8B, 0x77, 0x10);						// mov r14, [r15 + 16]
+		}
+
+		void emit_check_range(int32_t min, int32_t max) noexcept {
+			size_t slow_path_jump = 0;
+			size_t done_jump = 0;
+			// NOTE: The data pointer is always inside of the tape, so only one side can fail most of the time.
+			if (min < 0) {
+				emit(0x49, 0x8D, 0x84, 0x24); emit_int32(min);			// lea rax, [r12 + min]
+				emit(0x4C, 0x39, 0xE8);						// cmp rax, r13
+				emit(0x0F, 0x82); slow_path_jump = code_length; emit_int32(0);	// jb slow_path
+			}
+			if (max > 0) {
+				emit(0x49, 0x8D, 0x84, 0x24); emit_int32(max);			// lea rax, [r12 + max]
+				emit(0x4C, 0x39, 0xF0);						// cmp rax, r14
+				emit(0x0F, 0x82); done_jump = code_length; emit_int32(0);	// jb done
+			}
+			else {
+				emit(0xE9); done_jump = code_length; emit_int32(0);		// jmp done
+			}
+			if (slow_path_jump) { patch_int32(slow_path_jump, (int32_t)(code_length - (slow_path_jump + 4))); }
+			emit_store_data_ptr();
+			emit(0x48, 0x89, 0xDF);							// mov rdi, rbx
+			emit(0x48, 0xC7, 0xC6); emit_int32(min);				// mov rsi, min
+			emit(0x48, 0xC7, 0xC2); emit_int32(max);				// mov rdx, max
+			emit_call(&check_range_stub);
+			emit_exit_if_false(brainfuck_run_return_t::ALLOCATION_FAILURE);
+			emit_reload_context();
+			patch_int32(done_jump, (int32_t)(code_length - (done_jump + 4)));
+		}
+
+		void emit_io(uint32_t (*stub)(jitted_brainfuck_t*, uint8_t*)) noexcept {
+			emit(0x48, 0x89, 0xDF);							// mov rdi, rbx
+			emit(0x4C, 0x89, 0xE6);							// mov rsi, r12
+			emit_call(stub);
+			emit(0x83, 0xF8, (uint8_t)brainfuck_run_return_t::SUCCESS);		// cmp eax, SUCCESS
+			emit(0x0F, 0x85); emit_jump_target(0);					// jne exit
+		}
+
+		void emit_scan(bool (*stub)(jitted_brainfuck_t*)) noexcept {
+			emit(0x41, 0x80, 0x3C, 0x24, 0x00);					// cmp byte [r12], 0
+			emit(0x0F, 0x84); size_t skip_jump = code_length; emit_int32(0);	// je skip
+			emit_store_data_ptr();
+			emit(0x48, 0x89, 0xDF);							// mov rdi, rbx
+			emit_call(stub);
+			emit_exit_if_false(brainfuck_run_return_t::ALLOCATION_FAILURE);
+			emit_reload_context();
+			patch_int32(skip_jump, (int32_t)(code_length - (skip_jump + 4)));
+		}
+
+		// NOTE: instruction_offsets[i] is the position of the code for instruction i, which is how loops find each other.
+		void emit_program(const ir::instruction_buffer_t& program, size_t* instruction_offsets) noexcept {
+			// NOTE: The exit sequence comes first, that way every exit is a backwards jump to position 0 and doesn't need patching.
+			emit_store_data_ptr();
+			emit(0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B);		// pop r15, r14, r13, r12, rbx
+			emit(0xC3);								// ret
+
+			size_t entry_offset = code_length;
+			emit(0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57);		// push rbx, r12, r13, r14, r15 (keeps the stack 16-byte aligned)
+			emit(0x48, 0x89, 0xFB);							// mov rbx, rdi
+			emit(0x49, 0x89, 0xF7);							// mov r15, rsi
+			emit_reload_context();
+
+			for (size_t i = 0; i < program.length; i++) {
+				const ir::instruction_t& instruction = program[i];
+				instruction_offsets[i] = code_length;
+				switch (instruction.op) {
+				case ir::op_t::ADD:
+					emit(0x41, 0x80, 0x04, 0x24, (uint8_t)instruction.value);	// add byte [r12], value
+					break;
+				case ir::op_t::MOVE:
+					emit_check_range(instruction.min, instruction.max);
+					emit(0x49, 0x81, 0xC4); emit_int32(instruction.value);	// add r12, value
+					break;
+				case ir::op_t::LOOP_BEGIN:
+					emit(0x41, 0x80, 0x3C, 0x24, 0x00);			// cmp byte [r12], 0
+					emit(0x0F, 0x84); emit_int32(0);			// je (patched by the LOOP_END)
+					break;
+				case ir::op_t::LOOP_END:
+					emit(0x41, 0x80, 0x3C, 0x24, 0x00);			// cmp byte [r12], 0
+					emit(0x0F, 0x85); emit_jump_target(instruction_offsets[instruction.jump] + 11);	// jne body
+					patch_int32(instruction_offsets[instruction.jump] + 7, (int32_t)(code_length - (instruction_offsets[instruction.jump] + 11)));
+					break;
+				case ir::op_t::MULTIPLY_LOOP:
+					{
+						emit(0x41, 0x80, 0x3C, 0x24, 0x00);			// cmp byte [r12], 0
+						emit(0x0F, 0x84); size_t skip_jump = code_length; emit_int32(0);	// je skip
+						if (instruction.min < 0 || instruction.max > 0) { emit_check_range(instruction.min, instruction.max); }
+						if (instruction.jump != i + 1) {
+							// NOTE: The iterations, see helpers::multiply_loop_iterations.
+							emit(0x41, 0x0F, 0xB6, 0x04, 0x24);		// movzx eax, byte [r12]
+							if (instruction.value == 1) { emit(0xF6, 0xD8); }	// neg al
+							for (size_t target = i + 1; target < instruction.jump; target++) {
+								uint8_t factor = program[target].value;
+								if (factor == 1) { emit(0x41, 0x00, 0x84, 0x24); }	// add byte [r12 + offset], al
+								else {
+									emit(0x69, 0xC8); emit_int32(factor);		// imul ecx, eax, factor
+									emit(0x41, 0x00, 0x8C, 0x24);			// add byte [r12 + offset], cl
+								}
+								emit_int32(program[target].offset);
+							}
+						}
+						emit(0x41, 0xC6, 0x04, 0x24, 0x00);			// mov byte [r12], 0
+						patch_int32(skip_jump, (int32_t)(code_length - (skip_jump + 4)));
+					}
+					break;
+				// NOTE: Already handled by their MULTIPLY_LOOP.
+				case ir::op_t::MULTIPLY_ADD: break;
+				case ir::op_t::SCAN_RIGHT: emit_scan(&scan_right_stub); break;
+				case ir::op_t::SCAN_LEFT: emit_scan(&scan_left_stub); break;
+				case ir::op_t::INPUT: emit_io(&input_stub); break;
+				case ir::op_t::OUTPUT: emit_io(&output_stub); break;
+				case ir::op_t::END:
+					emit(0xB8); emit_int32((int32_t)brainfuck_run_return_t::SUCCESS);	// mov eax, SUCCESS
+					emit(0xE9); emit_jump_target(0);				// jmp exit
+					break;
+				}
+			}
+
+			entry_point = (jitted_function_t)(code + entry_offset);
+		}
+
+		// NOTE: Generous upper bound for the amount of code one instruction turns into (a MOVE with both checks is the biggest, at about 110 bytes).
+		static constexpr size_t max_instruction_code_size = 160;
+
+		/*
+		   Compiles the source into native code, replacing whatever was loaded before. Doesn't touch the tape, the new program continues on
+		   whatever the previous ones left there.
+		   Returns NONE on success. If it fails, nothing is loaded anymore (running then just succeeds without doing anything).
+		   NOTE: The generated code uses 32-bit offsets, sources that would need bigger ones are reported as ALLOCATION_FAILURE.
+		*/
+		ir::parse_error_t load(std::string_view source) noexcept {
+			release_code();
+
+			ir::instruction_buffer_t program = ir::compile(source, is_tape_fresh);
+			if (program.error != ir::parse_error_t::NONE) { return program.error; }
+			for (size_t i = 0; i < program.length; i++) {
+				const ir::instruction_t& instruction = program[i];
+				if (instruction.value != (int32_t)instruction.value || instruction.offset != (int32_t)instruction.offset || 
+				    instruction.min != (int32_t)instruction.min || instruction.max != (int32_t)instruction.max) { return ir::parse_error_t::ALLOCATION_FAILURE; }
+			}
+
+			size_t page_size = sysconf(_SC_PAGESIZE);
+			size_t capacity = ((program.length * max_instruction_code_size + 64) + page_size - 1) / page_size * page_size;
+			if (capacity / max_instruction_code_size < program.length || capacity > 0x7FFFFFFF) { return ir::parse_error_t::ALLOCATION_FAILURE; }
+			size_t* instruction_offsets = (size_t*)malloc(program.length * sizeof(size_t));
+			if (!instruction_offsets) { return ir::parse_error_t::ALLOCATION_FAILURE; }
+			void* memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED) { free(instruction_offsets); return ir::parse_error_t::ALLOCATION_FAILURE; }
+			code = (uint8_t*)memory;
+			code_capacity = capacity;
+
+			emit_program(program, instruction_offsets);
+			free(instruction_offsets);
+
+			// NOTE: Never writable and executable at the same time.
+			if (mprotect(code, code_capacity, PROT_READ | PROT_EXEC)) { release_code(); return ir::parse_error_t::ALLOCATION_FAILURE; }
+			return ir::parse_error_t::NONE;
+		}
+
+		brainfuck_run_return_t run() noexcept {
+			if (!data.data) { return brainfuck_run_return_t::ALLOCATION_FAILURE; }
+			if (!entry_point) { return brainfuck_run_return_t::SUCCESS; }
+			is_tape_fresh = false;
+			store_context();
+			brainfuck_run_return_t return_value = (brainfuck_run_return_t)entry_point(this, &jit_context);
+			load_context();
+			if (!this->flush_output() && return_value == brainfuck_run_return_t::SUCCESS) { return brainfuck_run_return_t::OUTPUT_FAILURE; }
+			return return_value;
+		}
+
+		bool reset_state_keep_vec_reserved() noexcept {
+			data.release_length_keep_reserve();
+			if (!data.push_back(0)) { return false; }
+			data_ptr = data.data;
+			data_end_ptr = data_ptr + 1;
+			is_tape_fresh = true;
+			return true;
+		}
+
+		bool reset_state_unreserve_vec() noexcept {
+			data.reset_everything();
+			if (!data.push_back(0)) { return false; }
+			data_ptr = data.data;
+			data_end_ptr = data_ptr + 1;
+			is_tape_fresh = true;
+			return true;
+		}
+	};
+#endif
+
+	/*
+	   Runs the same compiled program against a lot of independent jobs, spread over multiple threads.
+	   program_t is a compiled_brainfuck_t type. To be able to name it, the functors need to have names too (function pointers or structs
+	   instead of lambdas), see the README. Every job has its own copy of the functors and gets its own return value.
+	   Every worker keeps one tape for as long as the runner lives. Jobs don't allocate a tape of their own, they borrow the worker's tape
+	   (see compiled_brainfuck_t's tape-adopting constructor) and give it back through release_tape() when they're done.
+	   So once the tapes have grown to what the program needs, nothing gets allocated anymore.
+	   The same goes for the threads: they're started in the constructor, sleep on a condition variable between batches and are only joined
+	   in the destructor. run() bumps batch_generation and wakes them up, every thread runs exactly one batch per generation.
+	   Scheduling is work-stealing: every worker starts out with an equal slice of the jobs and works through it from the front.
+	   Once its slice is empty, it steals the back half of another worker's slice. If a thread can't be started, its slice simply gets stolen.
+	   NOTE: A slice is stored as one 64-bit atomic (begin in the low 32 bits, end in the high 32 bits), which is why run() only takes up to 2^32 - 1 jobs.
+	*/
+	template <typename program_t>
+	class brainfuck_batch_runner_t {
+	public:
+		using read_input_byte_t = typename program_t::read_input_byte_t;
+		using write_output_byte_t = typename program_t::write_output_byte_t;
+		using data_vector_t = typename program_t::data_vector_t;
+
+		struct job_t {
+			read_input_byte_t read_input_byte;
+			write_output_byte_t write_output_byte;
+			brainfuck_run_return_t return_value = brainfuck_run_return_t::SUCCESS;
+		};
+
+		// NOTE: Aligned to a cache line so that the workers don't fight over each other's slices when they don't have to.
+		struct alignas(64) worker_t {
+			std::atomic<uint64_t> jobs { 0 };
+			data_vector_t tape = data_vector_t::create_nulled_out_vec(1);
+			brainfuck_batch_runner_t* runner = nullptr;
+			size_t index = 0;
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			pthread_t thread;
+			bool thread_started = false;
+#endif
+		};
+
+		worker_t* workers = nullptr;
+		size_t worker_count = 0;
+		job_t* jobs = nullptr;
+
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+		// NOTE: Everything below is protected by batch_mutex.
+		pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+		pthread_cond_t batch_started = PTHREAD_COND_INITIALIZER;
+		pthread_cond_t batch_finished = PTHREAD_COND_INITIALIZER;
+		uint64_t batch_generation = 0;
+		size_t started_thread_count = 0;
+		size_t busy_thread_count = 0;
+		bool is_shutting_down = false;
+#endif
+
+		// NOTE: A worker count of 0 means one worker per online CPU. Without pthreads, there's always exactly one worker (the calling thread).
+		brainfuck_batch_runner_t(size_t requested_worker_count = 0) noexcept {
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			if (requested_worker_count == 0) {
+				long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+				requested_worker_count = cpu_count > 0 ? cpu_count : 1;
+			}
+#else
+			requested_worker_count = 1;
+#endif
+			workers = new (std::nothrow) worker_t[requested_worker_count];
+			if (!workers) { return; }
+			worker_count = requested_worker_count;
+			for (size_t i = 0; i < worker_count; i++) {
+				workers[i].runner = this;
+				workers[i].index = i;
+			}
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			// NOTE: The calling thread is worker 0, so it doesn't get a thread of its own.
+			for (size_t i = 1; i < worker_count; i++) {
+				workers[i].thread_started = pthread_create(&workers[i].thread, nullptr, worker_thread_entry, workers + i) == 0;
+				started_thread_count += workers[i].thread_started;
+			}
+#endif
+		}
+
+		brainfuck_batch_runner_t(const brainfuck_batch_runner_t& other) = delete;
+
+		~brainfuck_batch_runner_t() {
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			pthread_mutex_lock(&batch_mutex);
+			is_shutting_down = true;
+			pthread_cond_broadcast(&batch_started);
+			pthread_mutex_unlock(&batch_mutex);
+			for (size_t i = 1; i < worker_count; i++) {
+				if (workers[i].thread_started) { pthread_join(workers[i].thread, nullptr); }
+			}
+			pthread_cond_destroy(&batch_finished);
+			pthread_cond_destroy(&batch_started);
+			pthread_mutex_destroy(&batch_mutex);
+#endif
+			delete[] workers;
+		}
+
+		static constexpr uint64_t pack_jobs(uint32_t begin, uint32_t end) noexcept { return (uint64_t)begin | ((uint64_t)end << 32); }
+
+		static bool pop_job(worker_t& worker, size_t& job_index) noexcept {
+			uint64_t jobs = worker.jobs.load(std::memory_order_acquire);
+			while (true) {
+				uint32_t begin = jobs;
+				uint32_t end = jobs >> 32;
+				if (begin >= end) { return false; }
+				if (worker.jobs.compare_exchange_weak(jobs, pack_jobs(begin + 1, end), std::memory_order_acq_rel, std::memory_order_acquire)) {
+					job_index = begin;
+					return true;
+				}
+			}
+		}
+
+		/*
+		   Takes the back half of the first non-empty slice it finds (or the whole thing if there's only one job left) and makes it the thief's slice.
+		   NOTE: Only the owner ever turns an empty slice into a non-empty one, and the thief's slice is empty here,
+		   so nobody else can be touching it and a simple store is enough.
+		*/
+		bool steal_jobs(size_t thief_index) noexcept {
+			for (size_t i = 1; i < worker_count; i++) {
+				worker_t& victim = workers[(thief_index + i) % worker_count];
+				uint64_t jobs = victim.jobs.load(std::memory_order_acquire);
+				while (true) {
+					uint32_t begin = jobs;
+					uint32_t end = jobs >> 32;
+					if (begin >= end) { break; }
+					uint32_t middle = begin + (end - begin) / 2;
+					if (victim.jobs.compare_exchange_weak(jobs, pack_jobs(begin, middle), std::memory_order_acq_rel, std::memory_order_acquire)) {
+						workers[thief_index].jobs.store(pack_jobs(middle, end), std::memory_order_release);
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		void run_job(worker_t& worker, job_t& job) noexcept {
+			program_t program(job.read_input_byte, job.write_output_byte, std::move(worker.tape));
+			job.return_value = program.run();
+			worker.tape = program.release_tape();
+		}
+
+		void run_worker(worker_t& worker) noexcept {
+			size_t job_index;
+			while (true) {
+				if (pop_job(worker, job_index)) { run_job(worker, jobs[job_index]); continue; }
+				// NOTE: Nothing gets added while we're running, so if there's nothing left to steal, we're done.
+				if (!steal_jobs(worker.index)) { return; }
+			}
+		}
+
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+		void run_worker_thread(worker_t& worker) noexcept {
+			uint64_t finished_generation = 0;
+			pthread_mutex_lock(&batch_mutex);
+			while (true) {
+				while (batch_generation == finished_generation && !is_shutting_down) { pthread_cond_wait(&batch_started, &batch_mutex); }
+				if (is_shutting_down) { break; }
+				finished_generation = batch_generation;
+				pthread_mutex_unlock(&batch_mutex);
+
+				run_worker(worker);
+
+				pthread_mutex_lock(&batch_mutex);
+				if (--busy_thread_count == 0) { pthread_cond_signal(&batch_finished); }
+			}
+			pthread_mutex_unlock(&batch_mutex);
+		}
+
+		static void* worker_thread_entry(void* worker) noexcept {
+			((worker_t*)worker)->runner->run_worker_thread(*(worker_t*)worker);
+			return nullptr;
+		}
+#endif
+
+		/*
+		   Runs all the jobs and blocks until they're done. The calling thread works on the jobs as well.
+		   Returns false (without running anything) if the workers couldn't be allocated or if there are too many jobs.
+		   Otherwise, every job's return_value is filled in.
+		   NOTE: Only one run() at a time, the workers only ever work on one batch.
+		*/
+		bool run(job_t* batch_jobs, size_t job_count) noexcept {
+			if (!workers || job_count > (uint32_t)-1) { return false; }
+			jobs = batch_jobs;
+			for (size_t i = 0; i < worker_count; i++) {
+				workers[i].jobs.store(pack_jobs(job_count * i / worker_count, job_count * (i + 1) / worker_count), std::memory_order_relaxed);
+			}
+
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			// NOTE: The slices are published by the mutex, the threads only look at them after they've seen the new generation.
+			pthread_mutex_lock(&batch_mutex);
+			busy_thread_count = started_thread_count;
+			batch_generation++;
+			pthread_cond_broadcast(&batch_started);
+			pthread_mutex_unlock(&batch_mutex);
+#endif
+			run_worker(workers[0]);
+#ifdef META_BRAINFUCK_COMPILER_HAS_THREADS
+			pthread_mutex_lock(&batch_mutex);
+			while (busy_thread_count != 0) { pthread_cond_wait(&batch_finished, &batch_mutex); }
+			pthread_mutex_unlock(&batch_mutex);
+#endif
+			return true;
+		}
+	};
+
+	/*
+	   The functors of a program that was compiled ahead of time (see aot/compile_brainfuck.sh). The program lives in its own object file,
+	   so it can't know your functor types. These are what it gets instead: a pointer to your functor and a function that calls it.
+	   They're batched functors, so the call through the pointer only happens when the program's I/O buffers run empty or full.
+	   Per-byte functors work too, they get called once per byte (as usual) by the function behind the pointer.
+	   NOTE: The functor has to outlive the precompiled_input_t/precompiled_output_t, they only point to it.
+	*/
+	struct precompiled_input_t {
+		void* functor;
+		size_t (*read_input_bytes)(void* functor, uint8_t* buffer, size_t buffer_size) noexcept;
+
+		size_t operator()(uint8_t* buffer, size_t buffer_size) const noexcept { return read_input_bytes(functor, buffer, buffer_size); }
+
+		template <typename input_functor_t>
+		static precompiled_input_t from(input_functor_t& input_functor) noexcept {
+			static_assert(has_per_byte_input<input_functor_t> || has_batched_input<input_functor_t>, "precompiled_input_t::from() needs an input functor");
+			return { (void*)&input_functor, [](void* functor, uint8_t* buffer, size_t buffer_size) noexcept -> size_t {
+				if constexpr (has_per_byte_input<input_functor_t>) {
+					// NOTE: One byte per call, so that we never wait for more input than the program actually asked for.
+					uint16_t input_result = (*(input_functor_t*)functor)();
+					if (input_result == (uint16_t)-1) { return 0; }
+					*buffer = input_result;
+					return 1;
+				}
+				else { return (*(input_functor_t*)functor)(buffer, buffer_size); }
+			} };
+		}
+	};
+
+	struct precompiled_output_t {
+		void* functor;
+		bool (*write_output_bytes)(void* functor, const uint8_t* data, size_t length) noexcept;
+
+		bool operator()(const uint8_t* data, size_t length) const noexcept { return write_output_bytes(functor, data, length); }
+
+		template <typename output_functor_t>
+		static precompiled_output_t from(output_functor_t& output_functor) noexcept {
+			static_assert(has_per_byte_output<output_functor_t> || has_batched_output<output_functor_t>, "precompiled_output_t::from() needs an output functor");
+			return { (void*)&output_functor, [](void* functor, const uint8_t* data, size_t length) noexcept -> bool {
+				if constexpr (has_per_byte_output<output_functor_t>) {
+					for (size_t i = 0; i < length; i++) {
+						if ((output_status_t)(*(output_functor_t*)functor)(data[i]) != output_status_t::SUCCESS) { return false; }
+					}
+					return true;
+				}
+				else { return (output_status_t)(*(output_functor_t*)functor)(data, length) == output_status_t::SUCCESS; }
+			} };
+		}
+	};
+
+	using precompiled_brainfuck_t = brainfuck_run_return_t (*)(precompiled_input_t read_input_byte, precompiled_output_t write_output_byte) noexcept;
+
+	// NOTE: Runs a precompiled program (the entry point that META_DECLARE_PRECOMPILED_BRAINFUCK declared) with any functors, same as run() would.
+	template <typename input_functor_t, typename output_functor_t>
+	brainfuck_run_return_t run_precompiled_brainfuck(precompiled_brainfuck_t entry_point, input_functor_t& input_functor, output_functor_t& output_functor) noexcept {
+		return entry_point(precompiled_input_t::from(input_functor), precompiled_output_t::from(output_functor));
+	}
+
+	/*
+	   Runs lane_count instances of the same program at the same time, each one on its own tape, sharing one instruction stream ("SIMD lanes").
+	   The tapes are interleaved, cell i of lane l is tape[i * lane_count + l], so one cell of every lane is one contiguous row of lane_count bytes.
+	   With 16, 32 or 64 lanes, that's exactly one SSE, AVX2 or AVX-512 register, and everything that works on a row is a simple loop over
+	   a fixed number of bytes, which the compiler turns into vector instructions (compile with -mavx2/-mavx512bw or -march=native for the wide ones).
+	   All lanes share one data pointer, so this only works for code in which the pointer ends up in the same place for all of them:
+	   	--> Code outside of loops runs on every lane that's still running.
+		--> Balanced loops (see ir::annotate_balanced_loops) run with a lane mask (0xFF for the lanes that are still in the loop, 0 for the rest)
+		    until every lane's cell is zero. The pointer is back where it started at the end of every iteration, no matter which lanes took part.
+		    Their whole range is checked once on entry (like in the compiled version), so nothing in them is checked at all.
+		--> Everything else (unbalanced loops, scans, and balanced loops whose range check fails) can move the pointer differently for every lane.
+		    The lanes that get there (and actually enter the loop) are split off: their tape is copied into a normal compiled_brainfuck_t,
+		    which finishes the program for them starting at that loop (see compiled_brainfuck_t::resume_from), and their results are copied back.
+		    The lanes that skip the loop keep going in lockstep.
+	   So the more of the program's work happens in balanced loops, the better this gets. Programs that start with an unbalanced main loop
+	   won't get anything out of this, they just run one lane after the other.
+	   There's no input: ',' is an INPUT_FAILURE, exactly like it would be with an input functor that's out of input.
+	   The output of every lane is collected in lane_outputs, the results are in lane_return_values and lane_data_indices (where the pointer ended up).
+	*/
+	template <const char * const& source_code_const_string_original, size_t lane_count, size_t data_vector_bucket_size = META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT>
+	class lockstep_brainfuck_t {
+	public:
+		static_assert(lane_count != 0, "brainfuck compilation failed: lockstep_brainfuck_t needs at least one lane");
+
+		using data_vector_t = helpers::non_bad_vector<uint8_t, data_vector_bucket_size>;
+
+		// NOTE: The functors of the lanes that get split off.
+		struct lane_input_t { uint16_t operator()() const noexcept { return (uint16_t)-1; } };
+		struct lane_output_t {
+			data_vector_t* output;
+			bool operator()(uint8_t value) const noexcept { return output->push_back(value); }
+		};
+
+		// NOTE: The lanes start on whatever tapes set_cell gave them, so the program can't assume that the cells start out as zero.
+		using scalar_program_t = compiled_brainfuck_t<source_code_const_string_original, lane_input_t, lane_output_t, data_vector_bucket_size,
+		      tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT,
+		      instrumentation_t::NONE, 0, execution_t::BLOCKING, initial_tape_t::ARBITRARY>;
+
+		static constexpr const auto& program = scalar_program_t::program;
+
+		data_vector_t tape = data_vector_t::create_nulled_out_vec(lane_count);
+		size_t data_index = 0;
+
+		// NOTE: 0xFF for the lanes that are still running in lockstep, 0 for the ones that are done (or split off).
+		alignas(64) uint8_t live_lanes[lane_count];
+		brainfuck_run_return_t lane_return_values[lane_count];
+		size_t lane_data_indices[lane_count];
+		data_vector_t lane_outputs[lane_count];
+
+		// NOTE: The tape of the split-off lanes, it's reused for all of them so that we don't allocate a new one for every lane.
+		data_vector_t scalar_tape = data_vector_t::create_nulled_out_vec(1);
+
+		lockstep_brainfuck_t() noexcept = default;
+
+		lockstep_brainfuck_t(const lockstep_brainfuck_t& other) = delete;
+
+		size_t cell_count() const noexcept { return tape.length / lane_count; }
+
+		uint8_t* row(size_t cell_index) noexcept { return tape.data + cell_index * lane_count; }
+
+		// NOTE: Grows every lane's tape to at least new_cell_count cells (the new cells are zero).
+		bool reserve_cells(size_t new_cell_count) noexcept {
+			if (new_cell_count <= cell_count()) { return true; }
+			return tape.push_back_nulled_out((new_cell_count - cell_count()) * lane_count);
+		}
+
+		// NOTE: This is how you set up the initial tapes (before run()) and read the results (after it). Cells that don't exist yet are zero.
+		bool set_cell(size_t lane, size_t cell_index, uint8_t value) noexcept {
+			if (!reserve_cells(cell_index + 1)) { return false; }
+			tape[cell_index * lane_count + lane] = value;
+			return true;
+		}
+
+		uint8_t get_cell(size_t lane, size_t cell_index) const noexcept {
+			return cell_index < cell_count() ? tape[cell_index * lane_count + lane] : 0;
+		}
+
+		static bool is_any_lane_set(const uint8_t* mask) noexcept {
+			uint8_t result = 0;
+			for (size_t lane = 0; lane < lane_count; lane++) { result |= mask[lane]; }
+			return result != 0;
+		}
+
+		void finish_lanes(const uint8_t* mask, brainfuck_run_return_t return_value) noexcept {
+			for (size_t lane = 0; lane < lane_count; lane++) {
+				if (!mask[lane]) { continue; }
+				lane_return_values[lane] = return_value;
+				lane_data_indices[lane] = data_index;
+				live_lanes[lane] = 0;
+			}
+		}
+
+		// NOTE: The lanes that are set in mask, still running and whose current cell isn't zero (the ones that enter a loop).
+		void mask_nonzero_lanes(uint8_t* result, const uint8_t* mask) noexcept {
+			const uint8_t* cells = row(data_index);
+			for (size_t lane = 0; lane < lane_count; lane++) { result[lane] = mask[lane] & live_lanes[lane] & (cells[lane] != 0 ? 0xFF : 0); }
+		}
+
+		// NOTE: Same as compiled_brainfuck_t::reserve_range, for all lanes at once.
+		template <ptrdiff_t min, ptrdiff_t max>
+		bool reserve_range() noexcept {
+			if constexpr (min < 0) { if (data_index < (size_t)-min) { return false; } }
+			if constexpr (max > 0) { if (!reserve_cells(data_index + max + 1)) { return false; } }
+			return true;
+		}
+
+		// NOTE: Finishes the program for the lanes in mask on their own, starting at instruction_index. See the comment above the class.
+		template <size_t instruction_index>
+		void split_off_lanes(const uint8_t* mask) noexcept {
+			for (size_t lane = 0; lane < lane_count; lane++) {
+				if (!mask[lane]) { continue; }
+				live_lanes[lane] = 0;
+				lane_data_indices[lane] = data_index;
+
+				scalar_program_t scalar_program(lane_input_t { }, lane_output_t { lane_outputs + lane }, std::move(scalar_tape));
+				size_t lane_cell_count = cell_count();
+				if (!scalar_program.data.data || !scalar_program.data.push_back_nulled_out(lane_cell_count - scalar_program.data.length)) {
+					lane_return_values[lane] = brainfuck_run_return_t::ALLOCATION_FAILURE;
+				}
+				else {
+					for (size_t i = 0; i < lane_cell_count; i++) { scalar_program.data[i] = tape[i * lane_count + lane]; }
+					scalar_program.data_end_ptr = scalar_program.data.data + scalar_program.data.length;
+					scalar_program.data_ptr = scalar_program.data.data + data_index;
+					lane_return_values[lane] = scalar_program.finish_run(scalar_program.template resume_from<instruction_index>());
+
+					// NOTE: If the lane's tape grew, everyone else's does too (with zeros), so that the tapes stay interleaved.
+					if (!reserve_cells(scalar_program.data.length)) { lane_return_values[lane] = brainfuck_run_return_t::ALLOCATION_FAILURE; }
+					else {
+						for (size_t i = 0; i < scalar_program.data.length; i++) { tape[i * lane_count + lane] = scalar_program.data[i]; }
+						lane_data_indices[lane] = scalar_program.data_ptr - scalar_program.data.data;
+					}
+				}
+				scalar_tape = scalar_program.release_tape();
+			}
+		}
+
+		/*
+		   Runs one instruction on the lanes in mask (that are still live). is_balanced is true inside of balanced loops, where everything
+		   is already checked and the pointer can't diverge. Returns false if the lockstep run is over (every lane failed).
+		*/
+		template <size_t instruction_index, bool is_balanced>
+		bool run_lockstep_instruction(const uint8_t* mask) noexcept {
+			constexpr ir::instruction_t instruction = program.instructions[instruction_index];
+
+			if constexpr (instruction.op == ir::op_t::MOVE) {
+				// NOTE: Outside of balanced loops, every live lane runs this, so if it fails, it fails for all of them.
+				if constexpr (!is_balanced) {
+					if (!reserve_range<instruction.min, instruction.max>()) {
+						finish_lanes(live_lanes, brainfuck_run_return_t::ALLOCATION_FAILURE);
+						return false;
+					}
+				}
+				data_index += instruction.value;
+			}
+
+			else if constexpr (instruction.op == ir::op_t::ADD) {
+				uint8_t* cells = row(data_index);
+				for (size_t lane = 0; lane < lane_count; lane++) { cells[lane] += (uint8_t)instruction.value & mask[lane] & live_lanes[lane]; }
+			}
+
+			else if constexpr (instruction.op == ir::op_t::LOOP_BEGIN || instruction.op == ir::op_t::MULTIPLY_LOOP) {
+				alignas(64) uint8_t loop_mask[lane_count];
+				mask_nonzero_lanes(loop_mask, mask);
+				if (!is_any_lane_set(loop_mask)) { return true; }
+
+				constexpr bool is_lockstep_loop = instruction.op == ir::op_t::MULTIPLY_LOOP || instruction.value == 1;
+				if constexpr (!is_lockstep_loop) { split_off_lanes<instruction_index>(loop_mask); return true; }
+				else {
+					if constexpr (!is_balanced) {
+						if (!reserve_range<instruction.min, instruction.max>()) { split_off_lanes<instruction_index>(loop_mask); return true; }
+					}
+
+					if constexpr (instruction.op == ir::op_t::MULTIPLY_LOOP) {
+						uint8_t* origin = row(data_index);
+						// NOTE: Same as compiled_brainfuck_t::apply_multiply_loop, lanes that aren't in the loop add 0.
+						alignas(64) uint8_t iterations[lane_count];
+						for (size_t lane = 0; lane < lane_count; lane++) { iterations[lane] = helpers::multiply_loop_iterations(instruction.value, origin[lane]) & loop_mask[lane]; }
+						[this, &iterations]<size_t... target_indices>(std::index_sequence<target_indices...>) {
+							(add_multiple<program.instructions[instruction_index + 1 + target_indices]>(iterations), ...);
+						}(std::make_index_sequence<instruction.jump - instruction_index - 1>{});
+						for (size_t lane = 0; lane < lane_count; lane++) { origin[lane] &= ~loop_mask[lane]; }
+					}
+					else {
+						do {
+							run_lockstep_block<instruction_index + 1, true>(loop_mask);
+							mask_nonzero_lanes(loop_mask, loop_mask);
+						} while (is_any_lane_set(loop_mask));
+					}
+				}
+			}
+
+			// NOTE: Scans can't be done in lockstep at all (every lane stops somewhere else), so every lane that actually scans gets split off.
+			else if constexpr (instruction.op == ir::op_t::SCAN_RIGHT || instruction.op == ir::op_t::SCAN_LEFT) {
+				alignas(64) uint8_t scan_mask[lane_count];
+				mask_nonzero_lanes(scan_mask, mask);
+				if (is_any_lane_set(scan_mask)) { split_off_lanes<instruction_index>(scan_mask); }
+			}
+
+			else if constexpr (instruction.op == ir::op_t::INPUT) {
+				alignas(64) uint8_t input_mask[lane_count];
+				for (size_t lane = 0; lane < lane_count; lane++) { input_mask[lane] = mask[lane] & live_lanes[lane]; }
+				finish_lanes(input_mask, brainfuck_run_return_t::INPUT_FAILURE);
+			}
+
+			else if constexpr (instruction.op == ir::op_t::OUTPUT) {
+				const uint8_t* cells = row(data_index);
+				for (size_t lane = 0; lane < lane_count; lane++) {
+					if (!(mask[lane] & live_lanes[lane]) || lane_outputs[lane].push_back(cells[lane])) { continue; }
+					lane_return_values[lane] = brainfuck_run_return_t::OUTPUT_FAILURE;
+					lane_data_indices[lane] = data_index;
+					live_lanes[lane] = 0;
+				}
+			}
+
+			return true;
+		}
+
+		template <ir::instruction_t target>
+		void add_multiple(const uint8_t* iterations) noexcept {
+			uint8_t* cells = row(data_index + target.offset);
+			for (size_t lane = 0; lane < lane_count; lane++) { cells[lane] += (uint8_t)(target.value * iterations[lane]); }
+		}
+
+		template <size_t block_begin, bool is_balanced, size_t first_statement, size_t statement_count>
+		bool run_lockstep_statements(const uint8_t* mask) noexcept {
+			if constexpr (statement_count > scalar_program_t::max_fold_length) {
+				constexpr size_t first_half_count = statement_count / 2;
+				if (!run_lockstep_statements<block_begin, is_balanced, first_statement, first_half_count>(mask)) { return false; }
+				return run_lockstep_statements<block_begin, is_balanced, first_statement + first_half_count, statement_count - first_half_count>(mask);
+			}
+			else {
+				return [this, mask]<size_t... statement_indices>(std::index_sequence<statement_indices...>) {
+					return (run_lockstep_instruction<scalar_program_t::template block_statements<block_begin>.indices[first_statement + statement_indices], is_balanced>(mask) && ...);
+				}(std::make_index_sequence<statement_count>{});
+			}
+		}
+
+		template <size_t block_begin, bool is_balanced>
+		bool run_lockstep_block(const uint8_t* mask) noexcept {
+			return run_lockstep_statements<block_begin, is_balanced, 0, scalar_program_t::template block_length<block_begin>>(mask);
+		}
+
+		/*
+		   Runs the program on the first running_lane_count lanes (all of them by default). The tapes start out however you set them up (set_cell),
+		   the pointer starts at cell 0 for everyone. The other lanes don't run at all, they keep their tapes and report SUCCESS without any output.
+		   That's for the last batch of a sweep, when there are fewer instances left than lanes.
+		   Returns false (without running anything) if the tape couldn't be allocated, otherwise every lane's results are filled in.
+		   NOTE: Like with compiled_brainfuck_t, call one of the reset functions before running again (the outputs are appended to otherwise).
+		*/
+		bool run(size_t running_lane_count = lane_count) noexcept {
+			if (!tape.data) { return false; }
+			data_index = 0;
+			for (size_t lane = 0; lane < lane_count; lane++) {
+				live_lanes[lane] = lane < running_lane_count ? 0xFF : 0;
+				lane_return_values[lane] = brainfuck_run_return_t::SUCCESS;
+				lane_data_indices[lane] = 0;
+			}
+			if (run_lockstep_block<0, false>(live_lanes)) { finish_lanes(live_lanes, brainfuck_run_return_t::SUCCESS); }
+			return true;
+		}
+
+		bool reset_state_keep_vec_reserved() noexcept {
+			for (size_t lane = 0; lane < lane_count; lane++) { lane_outputs[lane].release_length_keep_reserve(); }
+			tape.release_length_keep_reserve();
+			return tape.push_back_nulled_out(lane_count);
+		}
+
+		bool reset_state_unreserve_vec() noexcept {
+			for (size_t lane = 0; lane < lane_count; lane++) { lane_outputs[lane].reset_everything(); }
+			tape.reset_everything();
+			return tape.push_back_nulled_out(lane_count);
+		}
+	};
+
+// NOTE: The callbacks can be any functor, including function pointers,
+// but you probably shouldn't use function pointers, since
+// calls to other functors are easier to optimize out for the compiler.
+// If you do use function pointers, at least have the
+// target functions reside in the same translation unit as the
+// compiled brainfuck program. That way, the compiler
+// should have a much easier time inlining the function calls.
+// NOTE: The variadic arguments are the template arguments of compiled_brainfuck_t that come after the functor types.
+#define META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, ...) []() { \
+auto read_input_byte_callback_temp = read_input_byte_callback; \
+auto write_output_byte_callback_temp = write_output_byte_callback; \
+static constexpr const char *source_code_ptr = source_code; \
+return meta::compiled_brainfuck_t<source_code_ptr, decltype(read_input_byte_callback_temp), decltype(write_output_byte_callback_temp), __VA_ARGS__>(read_input_byte_callback_temp, write_output_byte_callback_temp); \
+}()
+
+#define META_COMPILE_BRAINFUCK_WITH_CUSTOM_BUCKET_INC_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, bucket_inc_size) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, bucket_inc_size)
+//return meta::compiled_brainfuck_t<source_code_const_string>();	// This is something we had in a previous revision, seems weird but works.
+// Explanation: because it can't be a type in this context, the compiler is smart enought to pick up on the meaning.
+// For template args it's different because first an argument list is constructed and then that list is compared with every found template
+// definition of the function and a set of valid overloads is constructed. These are then further narrowed down by comparing the function
+// argument lists.
+// The bottom line is that the compiler doesn't know what type of argument it's shooting for before constructing the initial list, so it
+// always assumes type instead of non-type when it can, because that makes the most sense.
+
+#define META_COMPILE_BRAINFUCK(source_code, read_input_byte_callback, write_output_byte_callback) META_COMPILE_BRAINFUCK_WITH_CUSTOM_BUCKET_INC_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT)
+
+// NOTE: Uses helpers::reserved_vector for the memory, so pointer moves don't need any bounds checks and nothing ever gets reallocated.
+// The memory is limited to reserved_tape_size cells though (running out of it is reported as ALLOCATION_FAILURE).
+#define META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, reserved_tape_size) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, \
+		META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::RESERVED_VIRTUAL_MEMORY, reserved_tape_size)
+
+#define META_COMPILE_BRAINFUCK_WITH_RESERVED_TAPE(source_code, read_input_byte_callback, write_output_byte_callback) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(source_code, read_input_byte_callback, write_output_byte_callback, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT)
+
+// NOTE: Same as META_COMPILE_BRAINFUCK, but with instrumentation_t::PROFILING. Use print_profile() on the result to see where the time went.
+#define META_COMPILE_BRAINFUCK_WITH_PROFILING(source_code, read_input_byte_callback, write_output_byte_callback) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, \
+		META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, \
+		META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT, meta::instrumentation_t::PROFILING)
+
+// NOTE: Same as META_COMPILE_BRAINFUCK, but runs up to prefix_step_budget instructions of the input-free start of the program at compile-time.
+// Big budgets need a higher constexpr evaluation limit (CUSTOM_CONSTEXPR_MAX_STEPS in the makefile, -fconstexpr-loop-limit and -fconstexpr-ops-limit on GCC).
+#define META_COMPILE_BRAINFUCK_WITH_PREFIX_EVALUATION(source_code, read_input_byte_callback, write_output_byte_callback, prefix_step_budget) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, \
+		META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, \
+		META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT, meta::instrumentation_t::NONE, prefix_step_budget)
+
+// NOTE: Same as META_COMPILE_BRAINFUCK, but with execution_t::RESUMABLE. The functors can return the "would block" values and the program
+// then returns NEEDS_INPUT/NEEDS_OUTPUT_DRAIN, call resume() once they're ready again.
+#define META_COMPILE_BRAINFUCK_RESUMABLE(source_code, read_input_byte_callback, write_output_byte_callback) \
+META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(source_code, read_input_byte_callback, write_output_byte_callback, \
+		META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, \
+		META_BRAINFUCK_COMPILER_IO_BUFFER_SIZE_DEFAULT, meta::instrumentation_t::NONE, 0, meta::execution_t::RESUMABLE)
+
+// NOTE: Same as META_COMPILE_BRAINFUCK, but runs lane_count instances in lockstep (see meta::lockstep_brainfuck_t). There are no functors,
+// the program has no input and the output of every lane ends up in lane_outputs.
+#define META_COMPILE_BRAINFUCK_LOCKSTEP(source_code, lane_count) []() { \
+static constexpr const char *source_code_ptr = source_code; \
+return meta::lockstep_brainfuck_t<source_code_ptr, lane_count>(); \
+}()
+
+// NOTE: Declares the entry point of a program that was compiled ahead of time (see aot/compile_brainfuck.sh), put this wherever you want to use it.
+// The entry point runs the program once on a fresh tape and returns what run() returned, see meta::run_precompiled_brainfuck().
+// aot/precompiled_program.cpp uses the same macro to define it.
+#define META_DECLARE_PRECOMPILED_BRAINFUCK(entry_point_name) \
+meta::brainfuck_run_return_t entry_point_name(meta::precompiled_input_t read_input_byte, meta::precompiled_output_t write_output_byte) noexcept
 
 }
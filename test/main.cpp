@@ -23,6 +23,8 @@ int main() {
 	case meta::brainfuck_run_return_t::ALLOCATION_FAILURE: std::cout << "allocation failure\n"; break;
 	case meta::brainfuck_run_return_t::INPUT_FAILURE: std::cout << "input failure\n"; return 0;
 	case meta::brainfuck_run_return_t::OUTPUT_FAILURE: std::cout << "output failure\n"; return 0;
+	// NOTE: Only resumable programs return these.
+	case meta::brainfuck_run_return_t::NEEDS_INPUT: case meta::brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN: break;
 	}
 
 	std::cout << "state\n";
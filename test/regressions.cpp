@@ -0,0 +1,474 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <array>
+
+#include "meta_brainfuck_compiler.h"
+
+// NOTE: Checks for the optimization passes and the engines, one function per feature. Programs that some optimization got wrong
+// at some point end up in here too. The exit code is the number of failed checks.
+
+static int failure_count = 0;
+
+static void expect(bool condition, const char* description) {
+	if (condition) { return; }
+	std::cout << "FAILED: " << description << "\n";
+	failure_count++;
+}
+
+static auto no_input = []() -> uint16_t { return 256; };
+static auto no_output = [](uint8_t) -> bool { return true; };
+
+// NOTE: Clear loops don't have any targets, but the original loop still walked off the left end of the tape.
+static void test_loop_idioms() {
+	auto target_less_clear_loop = META_COMPILE_BRAINFUCK("+[-<>]", no_input, no_output);
+	expect(target_less_clear_loop.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "\"+[-<>]\" steps off the tape");
+	auto target_less_clear_loop_further_in = META_COMPILE_BRAINFUCK(">+[-<<>>]", no_input, no_output);
+	expect(target_less_clear_loop_further_in.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "\">+[-<<>>]\" steps off the tape");
+	auto target_less_clear_loop_in_range = META_COMPILE_BRAINFUCK(">+[-<>]", no_input, no_output);
+	expect(target_less_clear_loop_in_range.run() == meta::brainfuck_run_return_t::SUCCESS, "\">+[-<>]\" stays on the tape");
+}
+
+// NOTE: The reserved tape only checks the pointer at checkpoints, but it still has to catch every way off either end of it.
+static void test_reserved_tape() {
+	auto reserved_straight_underflow = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE("<+", no_input, no_output, 4096);
+	expect(reserved_straight_underflow.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "reserved \"<+\" steps off the left end");
+	auto reserved_loop_underflow = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE("+[<+]", no_input, no_output, 4096);
+	expect(reserved_loop_underflow.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "reserved \"+[<+]\" steps off the left end");
+	auto reserved_loop_overflow = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE("+[>+]", no_input, no_output, 4096);
+	expect(reserved_loop_overflow.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "reserved \"+[>+]\" steps off the right end");
+	auto reserved_stride_overflow = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(
+			"+[->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>+]", no_input, no_output, 4096);
+	expect(reserved_stride_overflow.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "reserved 64-cell strides step off the right end");
+	auto reserved_in_range = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE("++++++++++++++++[>++++++++++++++++<-]>[[->+<]>-]", no_input, no_output, 4096);
+	expect(reserved_in_range.run() == meta::brainfuck_run_return_t::SUCCESS, "reserved 256-cell walk stays on the tape");
+}
+
+// NOTE: Batched functors that count how often they get called.
+static const uint8_t* batched_input_data;
+static size_t batched_input_length;
+static size_t batched_output_call_count;
+static size_t batched_output_byte_count;
+static std::string batched_output_data;
+static bool is_batched_output_failing = false;
+static auto batched_input = [](uint8_t* buffer, size_t buffer_size) -> size_t {
+	size_t length = batched_input_length < buffer_size ? batched_input_length : buffer_size;
+	memcpy(buffer, batched_input_data, length);
+	batched_input_data += length;
+	batched_input_length -= length;
+	return length;
+};
+static auto batched_output = [](const uint8_t* data, size_t length) -> bool {
+	batched_output_call_count++;
+	batched_output_byte_count += length;
+	batched_output_data.append((const char*)data, length);
+	return !is_batched_output_failing;
+};
+
+static void test_batched_io() {
+	// NOTE: ',' used to flush the output buffer every time, even with input left in its buffer, which made ",[.,]" write every byte on its own.
+	static uint8_t echo_input[1001];
+	memset(echo_input, 'a', 1000);
+	batched_input_data = echo_input;
+	batched_input_length = sizeof(echo_input);
+	auto batched_echo = META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(",[.,]", batched_input, batched_output,
+			META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, 16);
+	expect(batched_echo.run() == meta::brainfuck_run_return_t::SUCCESS && batched_output_byte_count == 1000, "\",[.,]\" echoes its input");
+	expect(batched_output_call_count <= 1000 / 16 + 2, "\",[.,]\" only flushes when it needs more input");
+
+	// NOTE: With a 1-byte buffer, every byte is its own refill and its own flush. Running out of input (0 from the functor) is an INPUT_FAILURE,
+	// but everything that was printed before that still has to come out.
+	batched_input_data = (const uint8_t*)"abc";
+	batched_input_length = 3;
+	batched_output_data.clear();
+	auto tiny_buffer_echo = META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS(",[.,]", batched_input, batched_output,
+			META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, 1);
+	expect(tiny_buffer_echo.run() == meta::brainfuck_run_return_t::INPUT_FAILURE && batched_output_data == "abc", "\",[.,]\" with a 1-byte buffer reports running out of input");
+
+	// NOTE: A failing flush is an OUTPUT_FAILURE, no matter if it happens in the middle (buffer full), before a refill or at the end.
+	is_batched_output_failing = true;
+	auto failing_output_full = META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS("+.....", no_input, batched_output,
+			META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, 2);
+	expect(failing_output_full.run() == meta::brainfuck_run_return_t::OUTPUT_FAILURE, "a failing flush of a full buffer is an OUTPUT_FAILURE");
+	batched_input_data = (const uint8_t*)"a";
+	batched_input_length = 1;
+	auto failing_output_before_input = META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS("+.,", batched_input, batched_output,
+			META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, 16);
+	expect(failing_output_before_input.run() == meta::brainfuck_run_return_t::OUTPUT_FAILURE && batched_input_length == 1,
+			"a failing flush before a refill is an OUTPUT_FAILURE and doesn't read anything");
+	auto failing_output_at_end = META_COMPILE_BRAINFUCK_WITH_CUSTOM_TEMPLATE_ARGS("+.", no_input, batched_output,
+			META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT, meta::tape_backend_t::HEAP_VECTOR, META_BRAINFUCK_COMPILER_RESERVED_TAPE_SIZE_DEFAULT, 16);
+	expect(failing_output_at_end.run() == meta::brainfuck_run_return_t::OUTPUT_FAILURE, "a failing flush at the end is an OUTPUT_FAILURE");
+	is_batched_output_failing = false;
+}
+
+static std::string runtime_output;
+static auto collect_runtime_output = [](uint8_t value) -> bool { runtime_output.push_back(value); return true; };
+
+// NOTE: The most naive interpreter there is, as a reference that doesn't go through any of the optimization passes.
+struct reference_run_t {
+	std::string tape;
+	std::string output;
+	size_t data_index = 0;
+	meta::brainfuck_run_return_t return_value = meta::brainfuck_run_return_t::SUCCESS;
+
+	reference_run_t(const char* source_code, std::string initial_tape) : tape(std::move(initial_tape)) {
+		for (size_t i = 0; source_code[i] != '\0'; i++) {
+			switch (source_code[i]) {
+			case '+': tape[data_index]++; break;
+			case '-': tape[data_index]--; break;
+			case '>': if (++data_index == tape.length()) { tape.push_back(0); } break;
+			case '<': if (data_index-- == 0) { return_value = meta::brainfuck_run_return_t::ALLOCATION_FAILURE; return; } break;
+			case '.': output.push_back(tape[data_index]); break;
+			case ',': return_value = meta::brainfuck_run_return_t::INPUT_FAILURE; return;
+			case '[':
+				if (tape[data_index] != 0) { break; }
+				for (size_t depth = 1; depth != 0; ) { i++; depth += source_code[i] == '[' ? 1 : source_code[i] == ']' ? -1 : 0; }
+				break;
+			case ']':
+				if (tape[data_index] == 0) { break; }
+				for (size_t depth = 1; depth != 0; ) { i--; depth += source_code[i] == ']' ? 1 : source_code[i] == '[' ? -1 : 0; }
+				break;
+			}
+		}
+	}
+
+	uint8_t get_cell(size_t cell_index) const { return cell_index < tape.length() ? tape[cell_index] : 0; }
+};
+
+// NOTE: The runtime engines share the tape growth and the scans with the compiled version (see helpers::move_data_ptr).
+template <typename program_t>
+static void expect_runtime_engine_matches_reference(const char* source_code, const char* engine_name) {
+	reference_run_t reference(source_code, std::string(1, 0));
+	runtime_output.clear();
+	program_t program(no_input, collect_runtime_output);
+	bool is_matching = program.load(source_code) == meta::ir::parse_error_t::NONE && program.run() == reference.return_value && runtime_output == reference.output;
+	if (!is_matching) { std::cout << "FAILED: " << engine_name << " \"" << source_code << "\" matches the reference\n"; failure_count++; }
+}
+
+// NOTE: The tape outlives load(), so the optimizations can't assume that the next program starts on a zeroed tape.
+template <typename program_t>
+static void expect_load_continues_on_tape(const char* engine_name) {
+	runtime_output.clear();
+	program_t program(no_input, collect_runtime_output);
+	bool is_matching = program.load("+++") == meta::ir::parse_error_t::NONE && program.run() == meta::brainfuck_run_return_t::SUCCESS &&
+		program.load("[.-]") == meta::ir::parse_error_t::NONE && program.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == "\3\2\1";
+	if (!is_matching) { std::cout << "FAILED: " << engine_name << " \"[.-]\" continues on the tape \"+++\" left behind\n"; failure_count++; }
+}
+
+static constexpr const char* runtime_engine_sources[] = {
+	"+[-<>]", ">+[-<<>>]", ">+[-<>]", "+[>]+.", "+>+>+>+<<<[>]<.", "+>>>>>>>>>>>>>>>>>>>>+<<<<<<<<<<<<<<<<<<<<[>]+[<]>>.", "[<]>+[<].",
+	"++++[->>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>+<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<]>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>."
+};
+
+static void test_interpreter() {
+	using interpreter_t = meta::interpreted_brainfuck_t<decltype(no_input), decltype(collect_runtime_output)>;
+	for (const char* source_code : runtime_engine_sources) { expect_runtime_engine_matches_reference<interpreter_t>(source_code, "interpreter"); }
+	expect_load_continues_on_tape<interpreter_t>("interpreter");
+}
+
+static void test_jit() {
+#ifdef META_BRAINFUCK_COMPILER_HAS_JIT
+	using jit_t = meta::jitted_brainfuck_t<decltype(no_input), decltype(collect_runtime_output)>;
+	for (const char* source_code : runtime_engine_sources) { expect_runtime_engine_matches_reference<jit_t>(source_code, "JIT"); }
+	expect_load_continues_on_tape<jit_t>("JIT");
+#endif
+}
+
+// NOTE: The batch runner needs to be able to name the program type, so these have to be named functors.
+struct job_input_t {
+	const char* data;
+	size_t length;
+	uint16_t operator()() noexcept { if (length == 0) { return (uint16_t)-1; } length--; return (uint8_t)*data++; }
+};
+struct job_output_t {
+	std::string* output;
+	bool operator()(uint8_t value) noexcept { if (!output) { return false; } output->push_back(value); return true; }
+};
+static constexpr const char* batch_job_source = ",[.,]";
+using batch_program_t = meta::compiled_brainfuck_t<batch_job_source, job_input_t, job_output_t, META_BRAINFUCK_COMPILER_DATA_VECTOR_BUCKET_INC_DEFAULT>;
+
+static void test_batch_runner() {
+	// NOTE: A moved-from tape used to keep its length (the batch runner moves tapes in and out of its jobs), so resetting it walked over a nullptr.
+	auto moved_from_tape = meta::helpers::non_bad_vector<uint8_t, 16>::create_nulled_out_vec(4);
+	auto moved_to_tape = std::move(moved_from_tape);
+	moved_from_tape.release_length_keep_reserve();
+	expect(moved_from_tape.data == nullptr && moved_from_tape.length == 0 && moved_from_tape.bucket_length == 0 && moved_to_tape.length == 4, "a moved-from tape is empty");
+#ifdef META_BRAINFUCK_COMPILER_HAS_RESERVED_TAPE
+	// NOTE: Same for the reserved tape, a moved-from one that maps a new region has to start counting from 0 again.
+	auto moved_from_reserved_tape = meta::helpers::reserved_vector<uint8_t, 4096, 16>::create_nulled_out_vec(4);
+	auto moved_to_reserved_tape = std::move(moved_from_reserved_tape);
+	bool is_pushed = moved_from_reserved_tape.push_back(1);
+	expect(is_pushed && moved_from_reserved_tape.length == 1 && moved_to_reserved_tape.length == 4, "a moved-from reserved tape is empty");
+#endif
+
+	// NOTE: A lot more jobs than workers, run twice on the same runner (and with that, the same threads and tapes).
+	// Every third job ends with a 0 (SUCCESS), runs out of input (INPUT_FAILURE) or can't write its output (OUTPUT_FAILURE).
+	meta::brainfuck_batch_runner_t<batch_program_t> batch_runner(3);
+	for (size_t round = 0; round < 2; round++) {
+		constexpr size_t job_count = 100;
+		static std::string job_inputs[job_count];
+		static std::string job_outputs[job_count];
+		static meta::brainfuck_batch_runner_t<batch_program_t>::job_t jobs[job_count];
+		for (size_t i = 0; i < job_count; i++) {
+			job_inputs[i] = std::to_string(i + round * job_count);
+			if (i % 3 == 0) { job_inputs[i].push_back('\0'); }
+			job_outputs[i].clear();
+			jobs[i] = { job_input_t { job_inputs[i].data(), job_inputs[i].length() }, job_output_t { i % 3 == 2 ? nullptr : job_outputs + i } };
+		}
+		bool is_matching = batch_runner.run(jobs, job_count);
+		for (size_t i = 0; i < job_count; i++) {
+			std::string expected_output = i % 3 == 2 ? "" : std::to_string(i + round * job_count);
+			meta::brainfuck_run_return_t expected_return_value = i % 3 == 0 ? meta::brainfuck_run_return_t::SUCCESS :
+				i % 3 == 1 ? meta::brainfuck_run_return_t::INPUT_FAILURE : meta::brainfuck_run_return_t::OUTPUT_FAILURE;
+			is_matching &= jobs[i].return_value == expected_return_value && job_outputs[i] == expected_output;
+		}
+		expect(is_matching, "every batch job gets its own output and return value");
+	}
+}
+
+// NOTE: Loops count their iterations (multiply loops the iterations the original loop would have done), everything else is counted
+// through the loop it's in. Two runs with an input of 5, so every loop runs 10 times in total.
+static void test_profiling() {
+	static auto five_input = []() -> uint16_t { return 5; };
+	auto profiled = META_COMPILE_BRAINFUCK_WITH_PROFILING(",[.-],[->++<]", five_input, no_output);
+	using profiled_t = decltype(profiled);
+	bool is_profile_matching = profiled.run() == meta::brainfuck_run_return_t::SUCCESS && profiled.reset_state_keep_vec_reserved() &&
+		profiled.run() == meta::brainfuck_run_return_t::SUCCESS;
+	size_t profiled_loop_count = 0;
+	for (size_t i = 0; i < profiled_t::program_length; i++) {
+		switch (profiled_t::program.instructions[i].op) {
+		case meta::ir::op_t::INPUT: is_profile_matching &= profiled.profiled_execution_count(i) == 2; break;
+		case meta::ir::op_t::OUTPUT: is_profile_matching &= profiled.profiled_execution_count(i) == 10; break;
+		case meta::ir::op_t::LOOP_BEGIN: case meta::ir::op_t::MULTIPLY_LOOP:
+			is_profile_matching &= profiled.profile.loop_iterations[i] == 10;
+			profiled_loop_count++;
+			break;
+		default: break;
+		}
+	}
+	expect(is_profile_matching && profiled_loop_count == 2 && profiled.profile.run_count == 2 && profiled.profile.max_tape_length == 2,
+			"\",[.-],[->++<]\" profiles 10 iterations per loop over 2 runs");
+}
+
+static void test_prefix_evaluation() {
+	// NOTE: The prefix stops right before the first ',', its output comes first and the rest of the program picks up at the ','.
+	static auto x_input = []() -> uint16_t { return 'x'; };
+	runtime_output.clear();
+	auto prefix_until_input = META_COMPILE_BRAINFUCK_WITH_PREFIX_EVALUATION("++++++++[>++++++<-]>.,.", x_input, collect_runtime_output, 1000);
+	using prefix_until_input_t = decltype(prefix_until_input);
+	expect(prefix_until_input_t::prefix_info.output_length == 1 &&
+			prefix_until_input_t::program.instructions[prefix_until_input_t::prefix.resume_index].op == meta::ir::op_t::INPUT, "the prefix stops at the first ','");
+	expect(prefix_until_input.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == "0x", "the prefix output comes before the runtime output");
+
+	// NOTE: The scan makes the loop's cell unknown, so it stays a loop and the step budget runs out in the middle of it.
+	runtime_output.clear();
+	auto prefix_mid_loop = META_COMPILE_BRAINFUCK_WITH_PREFIX_EVALUATION("+>+++++<[>]<[.-]", x_input, collect_runtime_output, 10);
+	using prefix_mid_loop_t = decltype(prefix_mid_loop);
+	bool is_resuming_in_loop = false;
+	for (size_t i = 0; i < prefix_mid_loop_t::program_length; i++) {
+		const meta::ir::instruction_t& instruction = prefix_mid_loop_t::program.instructions[i];
+		if (instruction.op == meta::ir::op_t::LOOP_BEGIN && i < prefix_mid_loop_t::prefix.resume_index && prefix_mid_loop_t::prefix.resume_index < instruction.jump) {
+			is_resuming_in_loop = true;
+		}
+	}
+	expect(is_resuming_in_loop && prefix_mid_loop_t::prefix_info.output_length != 0, "the prefix of \"+>+++++<[>]<[.-]\" stops in the middle of the loop");
+	expect(prefix_mid_loop.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == "\5\4\3\2\1", "\"+>+++++<[>]<[.-]\" resumes in the middle of the loop");
+}
+
+// NOTE: How many instructions of one kind made it through the optimization passes.
+static size_t count_ops(const char* source_code, meta::ir::op_t op, bool is_tape_zeroed = true) {
+	meta::ir::instruction_buffer_t program = meta::ir::compile(source_code, is_tape_zeroed);
+	size_t result = 0;
+	for (size_t i = 0; i < program.length; i++) { result += program[i].op == op; }
+	return result;
+}
+
+// NOTE: Loops on cells that are known to be zero are dead, loops on known non-zero cells are unrolled (as long as they end up at zero).
+static void test_known_values() {
+	expect(count_ops("[+.]>+.", meta::ir::op_t::LOOP_BEGIN) == 0, "a leading loop is dead");
+	expect(count_ops(",[-][.]", meta::ir::op_t::LOOP_BEGIN) == 0, "a loop right after a clear loop is dead");
+	expect(count_ops("+++[.-]", meta::ir::op_t::LOOP_BEGIN) == 0 && count_ops("+++[.-]", meta::ir::op_t::OUTPUT) == 3, "\"+++[.-]\" is unrolled");
+	expect(count_ops(",[.-]", meta::ir::op_t::LOOP_BEGIN) == 1, "a loop on an input cell stays a loop");
+	expect(count_ops("[.-]", meta::ir::op_t::LOOP_BEGIN, false) == 1, "a leading loop on an arbitrary tape stays a loop");
+	runtime_output.clear();
+	auto unrolled_loop = META_COMPILE_BRAINFUCK("+++[.-]", no_input, collect_runtime_output);
+	expect(unrolled_loop.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == "\3\2\1", "unrolled \"+++[.-]\" prints 3 2 1");
+}
+
+// NOTE: The first loop of the program after the optimization passes (balanced loops have value 1 and their range in min and max).
+static meta::ir::instruction_t first_loop(const char* source_code) {
+	meta::ir::instruction_buffer_t program = meta::ir::compile(source_code);
+	for (size_t i = 0; i < program.length; i++) { if (program[i].op == meta::ir::op_t::LOOP_BEGIN) { return program[i]; } }
+	return meta::ir::instruction_t { };
+}
+
+// NOTE: ",[", 3000 '>', '.', 3000 '>', '.', 3000 '<', '.', 3000 '<', "-]". None of the loop's checkpoints covers more than 3000 cells,
+// but the loop is balanced, so it checks all 6001 of its cells at once on entry.
+static constexpr size_t wide_loop_segment_length = 3000;
+static constexpr std::array<char, 4 * wide_loop_segment_length + 8> wide_balanced_loop_characters = []() {
+	std::array<char, 4 * wide_loop_segment_length + 8> result { };
+	constexpr char segment_moves[] = { '>', '>', '<', '<' };
+	size_t length = 0;
+	result[length++] = ',';
+	result[length++] = '[';
+	for (size_t segment = 0; segment < 4; segment++) {
+		for (size_t i = 0; i < wide_loop_segment_length; i++) { result[length++] = segment_moves[segment]; }
+		result[length++] = segment == 3 ? '-' : '.';
+	}
+	result[length++] = ']';
+	return result;
+}();
+static constexpr const char* wide_balanced_loop = wide_balanced_loop_characters.data();
+
+static void test_balanced_loops() {
+	// NOTE: Balanced loops check their whole range once on entry, nested balanced loops included. Scans make a loop unbalanced.
+	meta::ir::instruction_t simple_balanced_loop = first_loop(",[>.<-]");
+	expect(simple_balanced_loop.value == 1 && simple_balanced_loop.min == 0 && simple_balanced_loop.max == 1, "\",[>.<-]\" is balanced");
+	meta::ir::instruction_t nested_balanced_loop = first_loop(",[>,[.-]<<.>-]");
+	expect(nested_balanced_loop.value == 1 && nested_balanced_loop.min == -1 && nested_balanced_loop.max == 1, "\",[>,[.-]<<.>-]\" is balanced");
+	expect(first_loop(",[>.]").op == meta::ir::op_t::LOOP_BEGIN && first_loop(",[>.]").value == 0, "\",[>.]\" isn't balanced");
+	expect(first_loop(",[[>]<.-]").op == meta::ir::op_t::LOOP_BEGIN && first_loop(",[[>]<.-]").value == 0, "\",[[>]<.-]\" isn't balanced");
+
+	// NOTE: The range check on entry has to report stepping off the tape, even though the '<' that does it is only reached later in the body.
+	static auto three_input = []() -> uint16_t { return 3; };
+	runtime_output.clear();
+	auto balanced_in_range = META_COMPILE_BRAINFUCK(">,[<.>-]", three_input, collect_runtime_output);
+	expect(balanced_in_range.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == std::string(3, '\0'), "balanced \">,[<.>-]\" stays on the tape");
+	auto balanced_off_tape = META_COMPILE_BRAINFUCK(",[<.>-]", three_input, no_output);
+	expect(balanced_off_tape.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "balanced \",[<.>-]\" steps off the tape");
+	auto reserved_balanced_off_tape = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(",[<.>-]", three_input, no_output, 4096);
+	expect(reserved_balanced_off_tape.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE, "reserved balanced \",[<.>-]\" steps off the tape");
+
+	// NOTE: The reserved tape's slack has to cover the whole range of a balanced loop, not just the ranges between its checkpoints,
+	// otherwise the range check on entry forms pointers outside of the mapping.
+	expect(first_loop(wide_balanced_loop).value == 1 && first_loop(wide_balanced_loop).max == 2 * wide_loop_segment_length, "the wide loop is balanced");
+	runtime_output.clear();
+	auto reserved_wide_loop = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(wide_balanced_loop, three_input, collect_runtime_output, 8192);
+	expect(meta::ir::max_checkpoint_range(decltype(reserved_wide_loop)::program.instructions) >= 2 * wide_loop_segment_length, "the slack covers the whole wide loop");
+	expect(reserved_wide_loop.run() == meta::brainfuck_run_return_t::SUCCESS && runtime_output == std::string(9, '\0'), "reserved wide loop stays on the tape");
+	runtime_output.clear();
+	auto reserved_wide_loop_off_tape = META_COMPILE_BRAINFUCK_WITH_CUSTOM_RESERVED_TAPE_SIZE(wide_balanced_loop, three_input, collect_runtime_output, 4096);
+	expect(reserved_wide_loop_off_tape.run() == meta::brainfuck_run_return_t::ALLOCATION_FAILURE && runtime_output == std::string(1, '\0'),
+			"reserved wide loop steps off the right end at its second '.'");
+}
+
+// NOTE: Resumable functors that only go through every other time, the rest of the time they would block.
+static const char* resumable_input = "abc";
+static size_t resumable_input_position = 0;
+static bool is_resumable_input_ready = false;
+static bool is_resumable_output_ready = false;
+static auto resumable_input_byte = []() -> uint16_t {
+	if (!is_resumable_input_ready) { return meta::input_byte_would_block; }
+	is_resumable_input_ready = false;
+	// NOTE: Ends with the 0 that terminates the string.
+	return (uint8_t)resumable_input[resumable_input_position++];
+};
+static auto resumable_output_byte = [](uint8_t value) -> meta::output_status_t {
+	if (!is_resumable_output_ready) { return meta::output_status_t::WOULD_BLOCK; }
+	is_resumable_output_ready = false;
+	runtime_output.push_back(value);
+	return meta::output_status_t::SUCCESS;
+};
+
+// NOTE: Every ',' and '.' suspends once before it goes through, resume() has to redo exactly that ',' or '.'.
+static void test_resumable() {
+	runtime_output.clear();
+	auto resumable_echo = META_COMPILE_BRAINFUCK_RESUMABLE(",[.,]", resumable_input_byte, resumable_output_byte);
+	size_t needs_input_count = 0;
+	size_t needs_output_drain_count = 0;
+	meta::brainfuck_run_return_t resumable_return_value = resumable_echo.run();
+	while (needs_input_count + needs_output_drain_count < 100) {
+		if (resumable_return_value == meta::brainfuck_run_return_t::NEEDS_INPUT) { needs_input_count++; is_resumable_input_ready = true; }
+		else if (resumable_return_value == meta::brainfuck_run_return_t::NEEDS_OUTPUT_DRAIN) { needs_output_drain_count++; is_resumable_output_ready = true; }
+		else { break; }
+		resumable_return_value = resumable_echo.resume();
+	}
+	expect(resumable_return_value == meta::brainfuck_run_return_t::SUCCESS && runtime_output == "abc" && needs_input_count == 4 && needs_output_drain_count == 3,
+			"resumable \",[.,]\" suspends on every ',' and '.' and picks up where it stopped");
+}
+
+static uint8_t initial_cell(size_t lane, size_t cell_index) { return (uint8_t)((lane + 1) * (cell_index + 1) % 7); }
+
+// NOTE: Every lane gets its own initial tape, the lanes (and the scalar version that split-off lanes run in) have to come out like the reference.
+// The tapes are only compared on success, since a failing multiply loop doesn't do any of its work, unlike the original loop.
+template <const char * const& source_code, size_t lane_count>
+static void expect_lockstep_matches_reference(const char* description) {
+	using lockstep_t = meta::lockstep_brainfuck_t<source_code, lane_count>;
+	constexpr size_t initial_cell_count = 4;
+
+	static lockstep_t lockstep_program;
+	for (size_t lane = 0; lane < lane_count; lane++) {
+		for (size_t cell_index = 0; cell_index < initial_cell_count; cell_index++) { lockstep_program.set_cell(lane, cell_index, initial_cell(lane, cell_index)); }
+	}
+	lockstep_program.run();
+
+	for (size_t lane = 0; lane < lane_count; lane++) {
+		std::string initial_tape;
+		for (size_t cell_index = 0; cell_index < initial_cell_count; cell_index++) { initial_tape.push_back(initial_cell(lane, cell_index)); }
+		reference_run_t reference(source_code, initial_tape);
+
+		typename lockstep_t::data_vector_t scalar_output;
+		typename lockstep_t::data_vector_t scalar_tape = lockstep_t::data_vector_t::create_nulled_out_vec(initial_cell_count);
+		memcpy(scalar_tape.data, initial_tape.data(), initial_cell_count);
+		typename lockstep_t::scalar_program_t scalar_program(typename lockstep_t::lane_input_t { }, typename lockstep_t::lane_output_t { &scalar_output }, std::move(scalar_tape));
+		meta::brainfuck_run_return_t scalar_return_value = scalar_program.run();
+
+		bool is_matching = lockstep_program.lane_return_values[lane] == reference.return_value && scalar_return_value == reference.return_value &&
+			std::string((const char*)lockstep_program.lane_outputs[lane].data, lockstep_program.lane_outputs[lane].length) == reference.output &&
+			std::string((const char*)scalar_output.data, scalar_output.length) == reference.output;
+		if (reference.return_value == meta::brainfuck_run_return_t::SUCCESS) {
+			is_matching &= lockstep_program.lane_data_indices[lane] == reference.data_index && (size_t)(scalar_program.data_ptr - scalar_program.data.data) == reference.data_index;
+			for (size_t cell_index = 0; cell_index < reference.tape.length() + 64; cell_index++) {
+				uint8_t scalar_cell = cell_index < scalar_program.data.length ? scalar_program.data[cell_index] : 0;
+				is_matching &= lockstep_program.get_cell(lane, cell_index) == reference.get_cell(cell_index) && scalar_cell == reference.get_cell(cell_index);
+			}
+		}
+		expect(is_matching, description);
+	}
+}
+
+static constexpr const char* leading_multiply_loop = "[->+<]>.";
+static constexpr const char* leading_nested_loops = "[->[->+<]<]>>.<[-]<.";
+static constexpr const char* leading_unbalanced_loop = "[>]<.[<]>.";
+static constexpr const char* known_after_write = "[-]>[-<+>]<.>++++[<+>-]<.";
+
+static void test_lockstep() {
+	// NOTE: Known value propagation used to assume that every lane's tape starts out as zero, so "[->+<]>." printed 0 everywhere.
+	auto leading_loop = META_COMPILE_BRAINFUCK_LOCKSTEP("[->+<]>.", 16);
+	for (size_t lane = 0; lane < 16; lane++) { leading_loop.set_cell(lane, 0, lane + 1); }
+	leading_loop.run();
+	for (size_t lane = 0; lane < 16; lane++) {
+		expect(leading_loop.lane_outputs[lane].length == 1 && leading_loop.lane_outputs[lane][0] == lane + 1, "\"[->+<]>.\" prints the lane's initial cell");
+	}
+
+	// NOTE: The lanes past running_lane_count don't run at all (the benchmark relies on that for its last batch).
+	auto partial_lanes = META_COMPILE_BRAINFUCK_LOCKSTEP("+.", 16);
+	partial_lanes.run(3);
+	for (size_t lane = 0; lane < 16; lane++) {
+		expect(partial_lanes.lane_outputs[lane].length == (lane < 3 ? 1 : 0) && partial_lanes.get_cell(lane, 0) == (lane < 3 ? 1 : 0), "run(3) only runs the first 3 lanes");
+	}
+
+	expect_lockstep_matches_reference<leading_multiply_loop, 16>("lockstep \"[->+<]>.\" matches the reference");
+	expect_lockstep_matches_reference<leading_nested_loops, 5>("lockstep \"[->[->+<]<]>>.<[-]<.\" matches the reference");
+	expect_lockstep_matches_reference<leading_unbalanced_loop, 32>("lockstep \"[>]<.[<]>.\" matches the reference");
+	expect_lockstep_matches_reference<known_after_write, 16>("lockstep \"[-]>[-<+>]<.>++++[<+>-]<.\" matches the reference");
+}
+
+int main() {
+	test_loop_idioms();
+	test_reserved_tape();
+	test_batched_io();
+	test_interpreter();
+	test_jit();
+	test_batch_runner();
+	test_profiling();
+	test_prefix_evaluation();
+	test_known_values();
+	test_balanced_loops();
+	test_resumable();
+	test_lockstep();
+
+	if (failure_count == 0) { std::cout << "all checks passed\n"; }
+	return failure_count;
+}